@@ -0,0 +1,51 @@
+use criterion::{black_box, criterion_group, criterion_main, BenchmarkId, Criterion};
+use damus::images::round_image;
+use damus::timeline::Timeline;
+use egui::{Color32, ColorImage};
+use enostr::EventId;
+
+fn event_id(n: u64) -> EventId {
+    let mut bytes = [0u8; 32];
+    bytes[..8].copy_from_slice(&n.to_le_bytes());
+    EventId::new(bytes)
+}
+
+fn bench_round_image(c: &mut Criterion) {
+    let mut group = c.benchmark_group("round_image");
+    for size in [32usize, 64, 128, 256] {
+        let image = ColorImage::new([size, size], Color32::WHITE);
+        group.bench_with_input(BenchmarkId::from_parameter(size), &image, |b, image| {
+            b.iter(|| {
+                let mut img = image.clone();
+                round_image(&mut img);
+                black_box(&img);
+            })
+        });
+    }
+    group.finish();
+}
+
+/// Timeline::insert is the per-event cost of process_event once parsing
+/// and dedup are done; measure it against pre-populated timelines so
+/// regressions show up at realistic sizes.
+fn bench_timeline_insert(c: &mut Criterion) {
+    let mut group = c.benchmark_group("timeline_insert");
+    for n in [1_000u64, 100_000, 1_000_000] {
+        group.bench_with_input(BenchmarkId::from_parameter(n), &n, |b, &n| {
+            let mut timeline = Timeline::new();
+            for i in 0..n {
+                timeline.insert(i, event_id(i));
+            }
+            // out-of-order inserts into the middle, like backfill
+            let mut next = n;
+            b.iter(|| {
+                next += 1;
+                black_box(timeline.insert(next / 2, event_id(next)));
+            })
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_round_image, bench_timeline_insert);
+criterion_main!(benches);
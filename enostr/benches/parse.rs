@@ -0,0 +1,54 @@
+use criterion::{black_box, criterion_group, criterion_main, Criterion};
+use enostr::{ClientMessage, Filter, Pubkey, RelayMessage};
+
+const ID: &str = "70b10f70c1318967eddf12527799411b1a9780ad9c43858f5e5fc2045486a13a";
+const PK: &str = "379e863e8357163b5bce5d2688dc4f1dcc2d505222fb8d74db600f30535dfdfe";
+const SIG: &str = "273a9cd5d3455b8311c18b75f8cc47f331e834c01241e94bdcc564f8138965674d3da38b559e912f1bf8f0f3a57a7e9088f41e6e2cd0a91abc5b58b9bd7d23df";
+
+/// A realistic EVENT frame: a couple of tags and whatever content the
+/// caller wants to stress the string scanner with.
+fn event_frame(content: &str) -> String {
+    format!(
+        r#"["EVENT","initial",{{"id":"{ID}","pubkey":"{PK}","created_at":1612809991,"kind":1,"tags":[["e","{ID}"],["p","{PK}"]],"content":"{content}","sig":"{SIG}"}}]"#
+    )
+}
+
+fn bench_from_json(c: &mut Criterion) {
+    let short = event_frame("hello nostr");
+    let long = event_frame(&"never gonna give you up ".repeat(100));
+    let escaped = event_frame(&r#"quotes \" and newlines \n everywhere "#.repeat(50));
+    let eose = r#"["EOSE","initial"]"#;
+
+    let mut group = c.benchmark_group("relay_message_from_json");
+    group.bench_function("event_short", |b| {
+        b.iter(|| RelayMessage::from_json(black_box(&short)))
+    });
+    group.bench_function("event_long", |b| {
+        b.iter(|| RelayMessage::from_json(black_box(&long)))
+    });
+    group.bench_function("event_escaped", |b| {
+        b.iter(|| RelayMessage::from_json(black_box(&escaped)))
+    });
+    group.bench_function("eose", |b| {
+        b.iter(|| RelayMessage::from_json(black_box(eose)))
+    });
+    group.finish();
+}
+
+fn bench_to_json(c: &mut Criterion) {
+    let mut pubkeys = vec![];
+    for n in 0..100u32 {
+        let mut bytes = [0u8; 32];
+        bytes[..4].copy_from_slice(&n.to_le_bytes());
+        pubkeys.push(Pubkey::new(bytes));
+    }
+    let filter = Filter::new().limit(100).kinds(vec![1, 42]).pubkeys(pubkeys);
+    let req = ClientMessage::req("initial".to_string(), vec![filter]);
+
+    c.bench_function("client_message_to_json/req_100_pubkeys", |b| {
+        b.iter(|| black_box(&req).to_json())
+    });
+}
+
+criterion_group!(benches, bench_from_json, bench_to_json);
+criterion_main!(benches);
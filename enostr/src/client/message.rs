@@ -1,5 +1,4 @@
 use crate::{Event, Filter};
-use serde_json::json;
 
 /// Messages sent by clients, received by relays
 #[derive(Debug, Eq, PartialEq)]
@@ -29,22 +28,57 @@ impl ClientMessage {
         ClientMessage::Close { sub_id }
     }
 
+    /// Serialize straight into a byte buffer. A REQ carrying a filter
+    /// with thousands of authors used to build a full Value tree and
+    /// tear it down again; this streams each element in place.
     pub fn to_json(&self) -> String {
+        let mut buf = Vec::with_capacity(128);
+        self.write_json(&mut buf)
+            .expect("client message serialization");
+        String::from_utf8(buf).expect("json is utf8")
+    }
+
+    fn write_json(&self, buf: &mut Vec<u8>) -> serde_json::Result<()> {
         match self {
-            Self::Event { event } => json!(["EVENT", event]).to_string(),
+            Self::Event { event } => {
+                buf.extend_from_slice(b"[\"EVENT\",");
+                serde_json::to_writer(&mut *buf, event)?;
+            }
             Self::Req { sub_id, filters } => {
-                let mut json = json!(["REQ", sub_id]);
-                let mut filters = json!(filters);
-
-                if let Some(json) = json.as_array_mut() {
-                    if let Some(filters) = filters.as_array_mut() {
-                        json.append(filters);
-                    }
+                buf.extend_from_slice(b"[\"REQ\",");
+                serde_json::to_writer(&mut *buf, sub_id)?;
+                for filter in filters {
+                    buf.push(b',');
+                    serde_json::to_writer(&mut *buf, filter)?;
                 }
-
-                json.to_string()
             }
-            Self::Close { sub_id } => json!(["CLOSE", sub_id]).to_string(),
+            Self::Close { sub_id } => {
+                buf.extend_from_slice(b"[\"CLOSE\",");
+                serde_json::to_writer(&mut *buf, sub_id)?;
+            }
         }
+        buf.push(b']');
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_req_json() {
+        let filter = Filter::new().limit(10).kinds(vec![1]);
+        let msg = ClientMessage::req("sub\"id".to_string(), vec![filter]);
+        assert_eq!(
+            msg.to_json(),
+            r#"["REQ","sub\"id",{"kinds":[1],"limit":10}]"#
+        );
+    }
+
+    #[test]
+    fn test_close_json() {
+        let msg = ClientMessage::close("subid".to_string());
+        assert_eq!(msg.to_json(), r#"["CLOSE","subid"]"#);
     }
 }
@@ -4,6 +4,8 @@ use serde_json;
 pub enum Error {
     MessageEmpty,
     MessageDecodeFailed,
+    HexDecodeFailed,
+    InvalidEventId,
     InvalidSignature,
     Json(serde_json::Error),
     Generic(String),
@@ -14,6 +16,8 @@ impl std::cmp::PartialEq for Error {
         match (self, other) {
             (Error::MessageEmpty, Error::MessageEmpty) => true,
             (Error::MessageDecodeFailed, Error::MessageDecodeFailed) => true,
+            (Error::HexDecodeFailed, Error::HexDecodeFailed) => true,
+            (Error::InvalidEventId, Error::InvalidEventId) => true,
             (Error::InvalidSignature, Error::InvalidSignature) => true,
             // This is slightly wrong but whatevs
             (Error::Json(..), Error::Json(..)) => true,
@@ -1,5 +1,6 @@
-use crate::{Error, Pubkey, Result};
-use serde_derive::{Deserialize, Serialize};
+use crate::{hex, Error, Pubkey, Result};
+use serde::{Deserialize, Serialize};
+use std::fmt;
 use std::hash::{Hash, Hasher};
 
 /// Event is the struct used to represent a Nostr event
@@ -7,7 +8,7 @@ use std::hash::{Hash, Hasher};
 pub struct Event {
     /// 32-bytes sha256 of the the serialized event data
     pub id: EventId,
-    /// 32-bytes hex-encoded public key of the event creator
+    /// 32-bytes public key of the event creator
     #[serde(rename = "pubkey")]
     pub pubkey: Pubkey,
     /// unix timestamp in seconds
@@ -20,7 +21,7 @@ pub struct Event {
     /// arbitrary string
     pub content: String,
     /// 64-bytes signature of the sha256 hash of the serialized event data, which is the same as the "id" field
-    pub sig: String,
+    pub sig: Sig,
 }
 
 // Implement Hash trait
@@ -43,8 +44,12 @@ impl Event {
         serde_json::from_str(s).map_err(Into::into)
     }
 
-    pub fn verify(&self) -> Result<Self> {
-        return Err(Error::InvalidSignature);
+    /// Check the event id against its contents and the schnorr signature
+    /// against the id. Hashing and schnorr verification both cost real
+    /// cpu, so the ingest path runs this on worker threads in batches
+    /// rather than calling it per event on the ui thread.
+    pub fn verify(&self) -> Result<()> {
+        crate::verify::verify_event(self)
     }
 
     /// This is just for serde sanity checking
@@ -59,16 +64,17 @@ impl Event {
         sig: &str,
     ) -> Result<Self> {
         let event = Event {
-            id: id.to_string().into(),
-            pubkey: pubkey.to_string().into(),
+            id: EventId::from_hex(id)?,
+            pubkey: Pubkey::from_hex(pubkey)?,
             created_at,
             kind,
             tags,
             content: content.to_string(),
-            sig: sig.to_string(),
+            sig: Sig::from_hex(sig)?,
         };
 
-        event.verify()
+        event.verify()?;
+        Ok(event)
     }
 }
 
@@ -80,23 +86,88 @@ impl std::str::FromStr for Event {
     }
 }
 
-#[derive(Serialize, Deserialize, Debug, Eq, PartialEq, Clone, Hash)]
-pub struct EventId(String);
+/// A 32-byte event id, stored inline. Hex only exists at the json
+/// boundary, so dedup lookups hash 32 bytes instead of 64 chars of
+/// ascii and ids are Copy.
+#[derive(Eq, PartialEq, Clone, Copy, Hash, PartialOrd, Ord)]
+pub struct EventId([u8; 32]);
 
-impl AsRef<str> for EventId {
-    fn as_ref(&self) -> &str {
+impl EventId {
+    pub fn new(bytes: [u8; 32]) -> Self {
+        EventId(bytes)
+    }
+
+    pub fn from_hex(s: &str) -> Result<Self> {
+        hex::decode_exact(s)
+            .map(EventId)
+            .ok_or(Error::HexDecodeFailed)
+    }
+
+    pub fn bytes(&self) -> &[u8; 32] {
         &self.0
     }
+
+    pub fn hex(&self) -> String {
+        hex::encode(&self.0)
+    }
+}
+
+impl fmt::Debug for EventId {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.write_str(&self.hex())
+    }
+}
+
+impl Serialize for EventId {
+    fn serialize<S: serde::Serializer>(&self, s: S) -> core::result::Result<S::Ok, S::Error> {
+        s.serialize_str(&self.hex())
+    }
+}
+
+impl<'de> Deserialize<'de> for EventId {
+    fn deserialize<D: serde::Deserializer<'de>>(d: D) -> core::result::Result<Self, D::Error> {
+        let s: &str = Deserialize::deserialize(d)?;
+        EventId::from_hex(s).map_err(|_| serde::de::Error::custom("expected 64 hex chars"))
+    }
+}
+
+/// A 64-byte schnorr signature, stored inline.
+#[derive(Eq, PartialEq, Clone, Copy, Hash)]
+pub struct Sig([u8; 64]);
+
+impl Sig {
+    pub fn new(bytes: [u8; 64]) -> Self {
+        Sig(bytes)
+    }
+
+    pub fn from_hex(s: &str) -> Result<Self> {
+        hex::decode_exact(s).map(Sig).ok_or(Error::HexDecodeFailed)
+    }
+
+    pub fn bytes(&self) -> &[u8; 64] {
+        &self.0
+    }
+
+    pub fn hex(&self) -> String {
+        hex::encode(&self.0)
+    }
+}
+
+impl fmt::Debug for Sig {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.write_str(&self.hex())
+    }
 }
 
-impl From<String> for EventId {
-    fn from(s: String) -> Self {
-        EventId(s)
+impl Serialize for Sig {
+    fn serialize<S: serde::Serializer>(&self, s: S) -> core::result::Result<S::Ok, S::Error> {
+        s.serialize_str(&self.hex())
     }
 }
 
-impl From<EventId> for String {
-    fn from(evid: EventId) -> Self {
-        evid.0
+impl<'de> Deserialize<'de> for Sig {
+    fn deserialize<D: serde::Deserializer<'de>>(d: D) -> core::result::Result<Self, D::Error> {
+        let s: &str = Deserialize::deserialize(d)?;
+        Sig::from_hex(s).map_err(|_| serde::de::Error::custom("expected 128 hex chars"))
     }
 }
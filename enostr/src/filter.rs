@@ -76,4 +76,19 @@ impl Filter {
         self.limit = Some(limit);
         self
     }
+
+    /// Whether this filter describes a standing stream (no upper time
+    /// bound), as opposed to a windowed one-shot query.
+    pub fn is_live(&self) -> bool {
+        self.until.is_none()
+    }
+
+    /// A copy of this filter that asks only for what may have been
+    /// missed since `at`. Any limit still applies, which caps the
+    /// replay after a very long outage.
+    pub fn gap_fill(&self, at: u64) -> Filter {
+        let mut filter = self.clone();
+        filter.since = Some(at);
+        filter
+    }
 }
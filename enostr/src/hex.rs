@@ -0,0 +1,58 @@
+//! Minimal hex encode/decode for fixed-size ids. Hand-rolled so we don't
+//! pull in a dependency for something this small.
+
+const HEX_CHARS: &[u8; 16] = b"0123456789abcdef";
+
+pub fn encode(bytes: &[u8]) -> String {
+    let mut s = String::with_capacity(bytes.len() * 2);
+    for b in bytes {
+        s.push(HEX_CHARS[(b >> 4) as usize] as char);
+        s.push(HEX_CHARS[(b & 0x0f) as usize] as char);
+    }
+    s
+}
+
+fn nibble(c: u8) -> Option<u8> {
+    match c {
+        b'0'..=b'9' => Some(c - b'0'),
+        b'a'..=b'f' => Some(c - b'a' + 10),
+        b'A'..=b'F' => Some(c - b'A' + 10),
+        _ => None,
+    }
+}
+
+/// Decode exactly N bytes of hex, rejecting anything with the wrong
+/// length or stray characters.
+pub fn decode_exact<const N: usize>(s: &str) -> Option<[u8; N]> {
+    let bytes = s.as_bytes();
+    if bytes.len() != N * 2 {
+        return None;
+    }
+
+    let mut out = [0u8; N];
+    for (i, b) in out.iter_mut().enumerate() {
+        let hi = nibble(bytes[i * 2])?;
+        let lo = nibble(bytes[i * 2 + 1])?;
+        *b = (hi << 4) | lo;
+    }
+    Some(out)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_roundtrip() {
+        let id = "6938e3cd841f3111dbdbd909f87fd52c3d1f1e4a07fd121d1243196e532811cb";
+        let bytes: [u8; 32] = decode_exact(id).unwrap();
+        assert_eq!(encode(&bytes), id);
+    }
+
+    #[test]
+    fn test_rejects_bad_input() {
+        assert!(decode_exact::<32>("abcd").is_none());
+        let bad = "zz38e3cd841f3111dbdbd909f87fd52c3d1f1e4a07fd121d1243196e532811cb";
+        assert!(decode_exact::<32>(bad).is_none());
+    }
+}
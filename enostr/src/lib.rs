@@ -2,15 +2,21 @@ mod client;
 mod error;
 mod event;
 mod filter;
+mod hex;
+pub mod metrics;
+pub mod note;
 mod profile;
 mod pubkey;
 mod relay;
+mod sha256;
+pub mod verify;
 
 pub use client::ClientMessage;
 pub use error::Error;
-pub use event::{Event, EventId};
+pub use event::{Event, EventId, Sig};
 pub use ewebsock;
 pub use filter::Filter;
+pub use note::Note;
 pub use profile::Profile;
 pub use pubkey::Pubkey;
 pub use relay::message::{RelayEvent, RelayMessage};
@@ -0,0 +1,147 @@
+//! Always-on counters for the relay path. These are plain relaxed
+//! atomics — an increment is a handful of nanoseconds — so they ship
+//! enabled in release builds, unlike the puffin scopes which need the
+//! profiling feature and a rebuild.
+
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, OnceLock};
+
+pub struct Counter(AtomicU64);
+
+impl Counter {
+    pub const fn new() -> Self {
+        Counter(AtomicU64::new(0))
+    }
+
+    #[inline]
+    pub fn incr(&self) {
+        self.0.fetch_add(1, Ordering::Relaxed);
+    }
+
+    #[inline]
+    pub fn add(&self, n: u64) {
+        self.0.fetch_add(n, Ordering::Relaxed);
+    }
+
+    pub fn get(&self) -> u64 {
+        self.0.load(Ordering::Relaxed)
+    }
+}
+
+/// A log2-bucketed histogram of nanosecond durations. Recording is one
+/// atomic increment; percentiles come out bucket-grained, which is all
+/// we need to tell "parse got slow" from "parse is fine".
+pub struct Histogram {
+    buckets: [AtomicU64; 64],
+}
+
+impl Histogram {
+    pub const fn new() -> Self {
+        const ZERO: AtomicU64 = AtomicU64::new(0);
+        Histogram {
+            buckets: [ZERO; 64],
+        }
+    }
+
+    #[inline]
+    pub fn record_ns(&self, ns: u64) {
+        let bucket = 64 - ns.leading_zeros() as usize;
+        self.buckets[bucket.min(63)].fetch_add(1, Ordering::Relaxed);
+    }
+
+    pub fn snapshot(&self) -> [u64; 64] {
+        let mut out = [0u64; 64];
+        for (i, b) in self.buckets.iter().enumerate() {
+            out[i] = b.load(Ordering::Relaxed);
+        }
+        out
+    }
+
+    /// Upper bound in ns of the bucket containing the given quantile.
+    pub fn approx_quantile(&self, q: f64) -> u64 {
+        let snapshot = self.snapshot();
+        let total: u64 = snapshot.iter().sum();
+        if total == 0 {
+            return 0;
+        }
+        let target = (total as f64 * q) as u64;
+        let mut seen = 0;
+        for (i, count) in snapshot.iter().enumerate() {
+            seen += count;
+            if seen > target {
+                return 1u64 << i;
+            }
+        }
+        u64::MAX
+    }
+}
+
+/// Relay frames received, across all relays.
+pub static RELAY_MESSAGES: Counter = Counter::new();
+
+/// Duplicate EVENT frames dropped by the pool before parsing.
+pub static DUP_FRAMES_DROPPED: Counter = Counter::new();
+
+/// Frames that failed to parse into a relay event.
+pub static PARSE_ERRORS: Counter = Counter::new();
+
+/// Time spent parsing one frame into a RelayEvent.
+pub static PARSE_NS: Histogram = Histogram::new();
+
+/// Per-relay message counters. Registration takes a lock once per relay;
+/// the pool keeps the Arc and increments lock-free after that.
+fn per_relay() -> &'static Mutex<Vec<(String, Arc<Counter>)>> {
+    static PER_RELAY: OnceLock<Mutex<Vec<(String, Arc<Counter>)>>> = OnceLock::new();
+    PER_RELAY.get_or_init(|| Mutex::new(vec![]))
+}
+
+pub fn relay_counter(url: &str) -> Arc<Counter> {
+    let mut relays = per_relay().lock().unwrap();
+    for (existing, counter) in relays.iter() {
+        if existing == url {
+            return counter.clone();
+        }
+    }
+    let counter = Arc::new(Counter::new());
+    relays.push((url.to_string(), counter.clone()));
+    counter
+}
+
+/// Snapshot of (relay url, messages received) for display and dumps.
+pub fn per_relay_counts() -> Vec<(String, u64)> {
+    per_relay()
+        .lock()
+        .unwrap()
+        .iter()
+        .map(|(url, counter)| (url.clone(), counter.get()))
+        .collect()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_histogram_quantile() {
+        let h = Histogram::new();
+        for _ in 0..90 {
+            h.record_ns(100); // bucket 7, upper bound 128
+        }
+        for _ in 0..10 {
+            h.record_ns(1_000_000);
+        }
+        assert_eq!(h.approx_quantile(0.5), 128);
+        assert!(h.approx_quantile(0.99) >= 1_000_000);
+    }
+
+    #[test]
+    fn test_relay_counter_registry() {
+        let a = relay_counter("wss://a.example");
+        let a2 = relay_counter("wss://a.example");
+        a.incr();
+        a2.incr();
+        let counts = per_relay_counts();
+        let found = counts.iter().find(|(url, _)| url == "wss://a.example");
+        assert_eq!(found.map(|(_, n)| *n), Some(2));
+    }
+}
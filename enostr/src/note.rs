@@ -1,87 +1,229 @@
-use crate::Event;
-use shatter::shard::Shards;
+use crate::{Event, EventId, Pubkey};
+use std::ops::Range;
+
+/// One piece of shattered note content. Text-bearing blocks hold byte
+/// ranges into the event's content instead of copied strings, so a Note
+/// adds a few words per block on top of the event itself.
+#[derive(Debug, Clone, Eq, PartialEq)]
+pub enum Block {
+    Text(Range<usize>),
+    /// range covers the whole url
+    Url(Range<usize>),
+    /// range covers the '#' and the word after it
+    Hashtag(Range<usize>),
+    /// a #[n] mention resolved through the event's tags
+    Mention(Mention),
+}
 
-#[derive(Debug, Eq, PartialEq)]
-struct RefId(i32);
+#[derive(Debug, Clone, Copy, Eq, PartialEq)]
+pub enum Mention {
+    Pubkey(Pubkey),
+    Event(EventId),
+}
 
-struct Ref<'a> {
-    ref_tag: u8,
-    relay_id: Option<&'a str>,
-    id: &'a str,
+/// Thread references pulled from the e-tags, positional NIP-10 style:
+/// one e-tag is the note we reply to, two or more means first is the
+/// thread root and last is the direct reply target.
+#[derive(Debug, Clone, Copy, Eq, PartialEq, Default)]
+pub struct EventRefs {
+    pub root: Option<EventId>,
+    pub reply: Option<EventId>,
 }
 
-impl<'a> RefId {
-    fn get_ref(self, tags: &'a Vec<Vec<String>>) -> Option<Ref<'a>> {
-        let ind = self.0 as usize;
+/// Precomputed render structure for one event: content shattered into
+/// blocks and tag references resolved. Built once when the event is
+/// ingested, so rendering a rich-text note is a walk over finished
+/// blocks, the same per-frame cost as a plain one.
+#[derive(Debug, Clone)]
+pub struct Note {
+    pub blocks: Vec<Block>,
+    pub refs: EventRefs,
+}
 
-        if ind > tags.len() - 1 {
-            return None;
+impl Note {
+    pub fn from_event(ev: &Event) -> Note {
+        Note {
+            blocks: shatter(&ev.content, &ev.tags),
+            refs: event_refs(&ev.tags),
         }
+    }
+}
 
-        let tag = &tags[ind];
+fn push_text(blocks: &mut Vec<Block>, range: Range<usize>) {
+    if !range.is_empty() {
+        blocks.push(Block::Text(range));
+    }
+}
 
-        if tag.len() < 2 {
-            return None;
+/// Split content into text, url, hashtag and mention blocks. All
+/// delimiters are ascii, so every range boundary lands on a char
+/// boundary even in multibyte content.
+fn shatter(content: &str, tags: &[Vec<String>]) -> Vec<Block> {
+    let bytes = content.as_bytes();
+    let mut blocks = vec![];
+    let mut text_start = 0;
+    let mut i = 0;
+
+    while i < bytes.len() {
+        let at_word_start = i == 0 || bytes[i - 1].is_ascii_whitespace();
+
+        if bytes[i] == b'#' && i + 1 < bytes.len() && bytes[i + 1] == b'[' {
+            if let Some((end, mention)) = parse_tag_mention(content, i, tags) {
+                push_text(&mut blocks, text_start..i);
+                blocks.push(Block::Mention(mention));
+                i = end;
+                text_start = end;
+                continue;
+            }
+        } else if bytes[i] == b'#'
+            && at_word_start
+            && i + 1 < bytes.len()
+            && bytes[i + 1].is_ascii_alphanumeric()
+        {
+            let mut end = i + 1;
+            while end < bytes.len() && (bytes[end].is_ascii_alphanumeric() || bytes[end] == b'_') {
+                end += 1;
+            }
+            push_text(&mut blocks, text_start..i);
+            blocks.push(Block::Hashtag(i..end));
+            i = end;
+            text_start = end;
+            continue;
+        } else if at_word_start
+            && (content[i..].starts_with("https://") || content[i..].starts_with("http://"))
+        {
+            let mut end = i;
+            while end < bytes.len() && !bytes[end].is_ascii_whitespace() {
+                end += 1;
+            }
+            push_text(&mut blocks, text_start..i);
+            blocks.push(Block::Url(i..end));
+            i = end;
+            text_start = end;
+            continue;
         }
 
-        if tag[0].len() != 1 {
-            return None;
-        }
+        i += 1;
+    }
 
-        let ref_tag = if let Some(rtag) = tag[0].as_bytes().first() {
-            *rtag
-        } else {
-            0
-        };
+    push_text(&mut blocks, text_start..bytes.len());
+    blocks
+}
 
-        let id = &tag[1];
-        if id.len() != 64 {
-            return None;
-        }
+/// Parse a `#[n]` token at position i and resolve it through the tags.
+/// Returns the end offset of the token and the mention, or None when the
+/// token is malformed or points at a tag we can't use — in which case it
+/// stays plain text.
+fn parse_tag_mention(content: &str, i: usize, tags: &[Vec<String>]) -> Option<(usize, Mention)> {
+    let bytes = content.as_bytes();
+    let digit_start = i + 2;
+    let mut j = digit_start;
+    while j < bytes.len() && bytes[j].is_ascii_digit() {
+        j += 1;
+    }
+    if j == digit_start || j >= bytes.len() || bytes[j] != b']' {
+        return None;
+    }
 
-        let relay_id = if tag[2].len() == 0 {
-            None
-        } else {
-            Some(&*tag[2])
-        };
-
-        Some(Ref {
-            ref_tag,
-            relay_id,
-            id,
-        })
+    let ind: usize = content[digit_start..j].parse().ok()?;
+    let tag = tags.get(ind)?;
+    if tag.len() < 2 {
+        return None;
     }
-}
 
-enum MentionType {
-    Pubkey,
-    Event,
-}
+    let mention = match tag[0].as_str() {
+        "p" => Mention::Pubkey(Pubkey::from_hex(&tag[1]).ok()?),
+        "e" => Mention::Event(EventId::from_hex(&tag[1]).ok()?),
+        _ => return None,
+    };
 
-struct Mention {
-    index: Option<i32>,
-    typ: MentionType,
-    refid: RefId,
+    Some((j + 1, mention))
 }
 
-enum EventRef {
-    Mention(Mention),
-    ThreadId(RefId),
-    Reply(RefId),
-    ReplyToRoot(RefId),
-}
+fn event_refs(tags: &[Vec<String>]) -> EventRefs {
+    let mut es: Vec<EventId> = vec![];
+    for tag in tags {
+        if tag.len() >= 2 && tag[0] == "e" {
+            if let Ok(id) = EventId::from_hex(&tag[1]) {
+                es.push(id);
+            }
+        }
+    }
 
-struct EventRefs {
-    refs: Vec<EventRef>,
+    match es.len() {
+        0 => EventRefs::default(),
+        1 => EventRefs {
+            root: Some(es[0]),
+            reply: Some(es[0]),
+        },
+        n => EventRefs {
+            root: Some(es[0]),
+            reply: Some(es[n - 1]),
+        },
+    }
 }
 
-struct DM {
-    decrypted: Option<String>,
-    shards: Shards,
-}
+#[cfg(test)]
+mod tests {
+    use super::*;
 
-struct Note {
-    event: NostrEvent,
-    shards: Shards,
-    refs: EventRef,
+    const ID: &str = "70b10f70c1318967eddf12527799411b1a9780ad9c43858f5e5fc2045486a13a";
+    const PK: &str = "379e863e8357163b5bce5d2688dc4f1dcc2d505222fb8d74db600f30535dfdfe";
+
+    #[test]
+    fn test_plain_text_is_one_block() {
+        let blocks = shatter("gm nostr", &[]);
+        assert_eq!(blocks, vec![Block::Text(0..8)]);
+    }
+
+    #[test]
+    fn test_url_and_hashtag() {
+        let content = "see https://damus.io for #nostr stuff";
+        let blocks = shatter(content, &[]);
+        assert_eq!(
+            blocks,
+            vec![
+                Block::Text(0..4),
+                Block::Url(4..20),
+                Block::Text(20..25),
+                Block::Hashtag(25..31),
+                Block::Text(31..37),
+            ]
+        );
+        assert_eq!(&content[4..20], "https://damus.io");
+        assert_eq!(&content[25..31], "#nostr");
+    }
+
+    #[test]
+    fn test_tag_mention() {
+        let tags = vec![vec!["p".to_string(), PK.to_string()]];
+        let blocks = shatter("hi #[0]!", &tags);
+        assert_eq!(
+            blocks,
+            vec![
+                Block::Text(0..3),
+                Block::Mention(Mention::Pubkey(Pubkey::from_hex(PK).unwrap())),
+                Block::Text(7..8),
+            ]
+        );
+    }
+
+    #[test]
+    fn test_dangling_mention_stays_text() {
+        let blocks = shatter("out of range #[4]", &[]);
+        assert_eq!(blocks, vec![Block::Text(0..17)]);
+    }
+
+    #[test]
+    fn test_event_refs_positional() {
+        let e = |id: &str| vec!["e".to_string(), id.to_string()];
+        let other = "1111111111111111111111111111111111111111111111111111111111111111";
+
+        let refs = event_refs(&[e(ID)]);
+        assert_eq!(refs.root, refs.reply);
+
+        let refs = event_refs(&[e(ID), e(other)]);
+        assert_eq!(refs.root, Some(EventId::from_hex(ID).unwrap()));
+        assert_eq!(refs.reply, Some(EventId::from_hex(other).unwrap()));
+    }
 }
@@ -1,38 +1,99 @@
-use serde_json::Value;
+use crate::Result;
+use serde::{Deserialize, Deserializer};
 
-#[derive(Debug, Clone)]
-pub struct Profile(Value);
+/// A parsed kind-0 profile. The content json is parsed once at ingest
+/// into this flat record, so render-path accessors are plain field reads
+/// instead of per-frame lookups into a json tree, and unknown fields are
+/// dropped instead of kept resident for every cached profile.
+#[derive(Debug, Clone, Default, Deserialize)]
+pub struct Profile {
+    #[serde(default, deserialize_with = "string_or_none")]
+    pub name: Option<String>,
+    #[serde(default, deserialize_with = "string_or_none")]
+    pub display_name: Option<String>,
+    #[serde(default, deserialize_with = "string_or_none")]
+    pub picture: Option<String>,
+    #[serde(default, deserialize_with = "string_or_none")]
+    pub banner: Option<String>,
+    #[serde(default, deserialize_with = "string_or_none")]
+    pub about: Option<String>,
+    #[serde(default, deserialize_with = "string_or_none")]
+    pub website: Option<String>,
+    #[serde(default, deserialize_with = "string_or_none")]
+    pub lud06: Option<String>,
+    #[serde(default, deserialize_with = "string_or_none")]
+    pub lud16: Option<String>,
+    #[serde(default, deserialize_with = "string_or_none")]
+    pub nip05: Option<String>,
+}
+
+/// Wild profile data likes to put numbers and nulls where strings
+/// belong; treat anything that isn't a string as absent instead of
+/// rejecting the whole profile.
+fn string_or_none<'de, D: Deserializer<'de>>(
+    d: D,
+) -> core::result::Result<Option<String>, D::Error> {
+    let v: Option<serde_json::Value> = Option::deserialize(d)?;
+    Ok(v.and_then(|v| match v {
+        serde_json::Value::String(s) => Some(s),
+        _ => None,
+    }))
+}
 
 impl Profile {
-    pub fn new(value: Value) -> Profile {
-        Profile(value)
+    pub fn from_json(s: &str) -> Result<Profile> {
+        serde_json::from_str(s).map_err(Into::into)
     }
 
     pub fn name(&self) -> Option<&str> {
-        return self.0["name"].as_str();
+        self.name.as_deref()
     }
 
     pub fn display_name(&self) -> Option<&str> {
-        return self.0["display_name"].as_str();
+        self.display_name.as_deref()
     }
 
     pub fn lud06(&self) -> Option<&str> {
-        return self.0["lud06"].as_str();
+        self.lud06.as_deref()
     }
 
     pub fn lud16(&self) -> Option<&str> {
-        return self.0["lud16"].as_str();
+        self.lud16.as_deref()
     }
 
     pub fn about(&self) -> Option<&str> {
-        return self.0["about"].as_str();
+        self.about.as_deref()
     }
 
     pub fn picture(&self) -> Option<&str> {
-        return self.0["picture"].as_str();
+        self.picture.as_deref()
     }
 
     pub fn website(&self) -> Option<&str> {
-        return self.0["website"].as_str();
+        self.website.as_deref()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_parse_profile() -> Result<()> {
+        let profile = Profile::from_json(
+            r#"{"name":"jb55","picture":"https://damus.io/img/jb55.png","unknown_field":42}"#,
+        )?;
+        assert_eq!(profile.name(), Some("jb55"));
+        assert_eq!(profile.picture(), Some("https://damus.io/img/jb55.png"));
+        assert_eq!(profile.display_name(), None);
+        Ok(())
+    }
+
+    #[test]
+    fn test_non_string_fields_are_absent() -> Result<()> {
+        let profile = Profile::from_json(r#"{"name":42,"about":null}"#)?;
+        assert_eq!(profile.name(), None);
+        assert_eq!(profile.about(), None);
+        Ok(())
     }
 }
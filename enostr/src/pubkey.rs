@@ -1,28 +1,47 @@
-use serde_derive::{Deserialize, Serialize};
+use crate::{hex, Error, Result};
+use serde::{Deserialize, Serialize};
+use std::fmt;
 
-#[derive(Serialize, Deserialize, Debug, Eq, PartialEq, Clone, Hash)]
-pub struct Pubkey(String);
+/// A 32-byte x-only public key, stored inline. Hex only exists at the
+/// json boundary.
+#[derive(Eq, PartialEq, Clone, Copy, Hash, PartialOrd, Ord)]
+pub struct Pubkey([u8; 32]);
 
-impl AsRef<str> for Pubkey {
-    fn as_ref(&self) -> &str {
+impl Pubkey {
+    pub fn new(bytes: [u8; 32]) -> Self {
+        Pubkey(bytes)
+    }
+
+    pub fn from_hex(s: &str) -> Result<Self> {
+        hex::decode_exact(s)
+            .map(Pubkey)
+            .ok_or(Error::HexDecodeFailed)
+    }
+
+    pub fn bytes(&self) -> &[u8; 32] {
         &self.0
     }
+
+    pub fn hex(&self) -> String {
+        hex::encode(&self.0)
+    }
 }
 
-impl From<String> for Pubkey {
-    fn from(s: String) -> Self {
-        Pubkey(s)
+impl fmt::Debug for Pubkey {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.write_str(&self.hex())
     }
 }
 
-impl From<&str> for Pubkey {
-    fn from(s: &str) -> Self {
-        Pubkey(s.to_owned())
+impl Serialize for Pubkey {
+    fn serialize<S: serde::Serializer>(&self, s: S) -> core::result::Result<S::Ok, S::Error> {
+        s.serialize_str(&self.hex())
     }
 }
 
-impl From<Pubkey> for String {
-    fn from(pk: Pubkey) -> Self {
-        pk.0
+impl<'de> Deserialize<'de> for Pubkey {
+    fn deserialize<D: serde::Deserializer<'de>>(d: D) -> core::result::Result<Self, D::Error> {
+        let s: &str = Deserialize::deserialize(d)?;
+        Pubkey::from_hex(s).map_err(|_| serde::de::Error::custom("expected 64 hex chars"))
     }
 }
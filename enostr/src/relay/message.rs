@@ -1,7 +1,6 @@
 use crate::Error;
 use crate::Event;
 use crate::Result;
-use serde_json::Value;
 
 use ewebsock::{WsEvent, WsMessage};
 
@@ -73,75 +72,175 @@ impl RelayMessage {
         RelayMessage::Event(sub_id, ev)
     }
 
-    // I was lazy and took this from the nostr crate. thx yuki!
+    /// Parse a relay frame in a single pass. We scan the array head by
+    /// hand and hand the event payload of EVENT frames directly to
+    /// [`Event::from_json`] as a borrowed slice of the websocket buffer,
+    /// so there is no intermediate `serde_json::Value` tree and the event
+    /// json is only parsed once.
     pub fn from_json(msg: &str) -> Result<Self> {
         if msg.is_empty() {
             return Err(Error::MessageEmpty);
         }
 
-        let v: Vec<Value> = serde_json::from_str(msg).map_err(|_| Error::MessageDecodeFailed)?;
+        let mut toks = Tokens::new(msg);
+        toks.expect(b'[')?;
+        let tag = toks.raw_string()?;
 
         // Notice
         // Relay response format: ["NOTICE", <message>]
-        if v[0] == "NOTICE" {
-            if v.len() != 2 {
-                return Err(Error::MessageDecodeFailed);
-            }
-            let v_notice: String =
-                serde_json::from_value(v[1].clone()).map_err(|_| Error::MessageDecodeFailed)?;
+        if tag == "NOTICE" {
+            toks.expect(b',')?;
+            let v_notice = toks.string()?;
+            toks.finish()?;
             return Ok(Self::notice(v_notice));
         }
 
         // Event
         // Relay response format: ["EVENT", <subscription id>, <event JSON>]
-        if v[0] == "EVENT" {
-            if v.len() != 3 {
-                return Err(Error::MessageDecodeFailed);
-            }
-
-            let event =
-                Event::from_json(&v[2].to_string()).map_err(|_| Error::MessageDecodeFailed)?;
+        if tag == "EVENT" {
+            toks.expect(b',')?;
+            let subscription_id = toks.string()?;
+            toks.expect(b',')?;
 
-            let subscription_id: String =
-                serde_json::from_value(v[1].clone()).map_err(|_| Error::MessageDecodeFailed)?;
+            let event = Event::from_json(toks.rest_object()?)
+                .map_err(|_| Error::MessageDecodeFailed)?;
+            toks.finish()?;
 
             return Ok(Self::event(event, subscription_id));
         }
 
         // EOSE (NIP-15)
         // Relay response format: ["EOSE", <subscription_id>]
-        if v[0] == "EOSE" {
-            if v.len() != 2 {
-                return Err(Error::MessageDecodeFailed);
-            }
-
-            let subscription_id: String =
-                serde_json::from_value(v[1].clone()).map_err(|_| Error::MessageDecodeFailed)?;
-
+        if tag == "EOSE" {
+            toks.expect(b',')?;
+            let subscription_id = toks.string()?;
+            toks.finish()?;
             return Ok(Self::eose(subscription_id));
         }
 
         // OK (NIP-20)
         // Relay response format: ["OK", <event_id>, <true|false>, <message>]
-        if v[0] == "OK" {
-            if v.len() != 4 {
-                return Err(Error::MessageDecodeFailed);
-            }
+        if tag == "OK" {
+            toks.expect(b',')?;
+            let event_id = toks.string()?;
+            toks.expect(b',')?;
+            let status = toks.bool()?;
+            toks.expect(b',')?;
+            let message = toks.string()?;
+            toks.finish()?;
+            return Ok(Self::ok(event_id, status, message));
+        }
+
+        Err(Error::MessageDecodeFailed)
+    }
+}
 
-            let event_id: String =
-                serde_json::from_value(v[1].clone()).map_err(|_| Error::MessageDecodeFailed)?;
+/// A tiny cursor over the top level of a relay frame. It only knows
+/// enough json to step over the array syntax and pull out scalar tokens;
+/// the event payload is sliced out whole and left to serde.
+struct Tokens<'a> {
+    msg: &'a str,
+    pos: usize,
+}
 
-            let status: bool =
-                serde_json::from_value(v[2].clone()).map_err(|_| Error::MessageDecodeFailed)?;
+impl<'a> Tokens<'a> {
+    fn new(msg: &'a str) -> Self {
+        Tokens { msg, pos: 0 }
+    }
 
-            let message: String =
-                serde_json::from_value(v[3].clone()).map_err(|_| Error::MessageDecodeFailed)?;
+    fn skip_ws(&mut self) {
+        let bytes = self.msg.as_bytes();
+        while self.pos < bytes.len() && bytes[self.pos].is_ascii_whitespace() {
+            self.pos += 1;
+        }
+    }
 
-            return Ok(Self::ok(event_id, status, message));
+    /// Expect the closing ']' followed by end of input.
+    fn finish(&mut self) -> Result<()> {
+        self.expect(b']')?;
+        self.skip_ws();
+        if self.pos == self.msg.len() {
+            Ok(())
+        } else {
+            Err(Error::MessageDecodeFailed)
         }
+    }
+
+    fn expect(&mut self, c: u8) -> Result<()> {
+        self.skip_ws();
+        if self.msg.as_bytes().get(self.pos) == Some(&c) {
+            self.pos += 1;
+            Ok(())
+        } else {
+            Err(Error::MessageDecodeFailed)
+        }
+    }
 
+    /// The quoted string token at the cursor, including quotes, escapes
+    /// left as-is. Scanning bytes is utf8-safe here because we only
+    /// compare against ascii and utf8 continuation bytes are >= 0x80.
+    fn string_token(&mut self) -> Result<&'a str> {
+        self.expect(b'"')?;
+        let bytes = self.msg.as_bytes();
+        let start = self.pos - 1;
+        while self.pos < bytes.len() {
+            match bytes[self.pos] {
+                b'\\' => self.pos += 2,
+                b'"' => {
+                    self.pos += 1;
+                    return Ok(&self.msg[start..self.pos]);
+                }
+                _ => self.pos += 1,
+            }
+        }
         Err(Error::MessageDecodeFailed)
     }
+
+    /// The contents of the string token at the cursor, without quotes and
+    /// without unescaping. Used for the frame tag, which never contains
+    /// escapes.
+    fn raw_string(&mut self) -> Result<&'a str> {
+        let tok = self.string_token()?;
+        Ok(&tok[1..tok.len() - 1])
+    }
+
+    /// The unescaped string at the cursor.
+    fn string(&mut self) -> Result<String> {
+        let tok = self.string_token()?;
+        serde_json::from_str(tok).map_err(|_| Error::MessageDecodeFailed)
+    }
+
+    fn bool(&mut self) -> Result<bool> {
+        self.skip_ws();
+        let rest = &self.msg[self.pos..];
+        if rest.starts_with("true") {
+            self.pos += 4;
+            Ok(true)
+        } else if rest.starts_with("false") {
+            self.pos += 5;
+            Ok(false)
+        } else {
+            Err(Error::MessageDecodeFailed)
+        }
+    }
+
+    /// Slice out the object that runs from the cursor to the last '}' in
+    /// the frame. The event json is always the final array element, so
+    /// the frame's last closing brace is the one that closes it — no need
+    /// to track nesting or string state.
+    fn rest_object(&mut self) -> Result<&'a str> {
+        self.skip_ws();
+        if self.msg.as_bytes().get(self.pos) != Some(&b'{') {
+            return Err(Error::MessageDecodeFailed);
+        }
+        let end = self.msg.rfind('}').ok_or(Error::MessageDecodeFailed)?;
+        if end < self.pos {
+            return Err(Error::MessageDecodeFailed);
+        }
+        let obj = &self.msg[self.pos..=end];
+        self.pos = end + 1;
+        Ok(obj)
+    }
 }
 
 #[cfg(test)]
@@ -217,6 +316,31 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_handle_event_with_tricky_content() -> Result<()> {
+        // content containing braces and an escaped subscription id
+        // shouldn't confuse the frame scanner
+        let msg = r#" [ "EVENT" , "sub\"id" , {"id":"70b10f70c1318967eddf12527799411b1a9780ad9c43858f5e5fcd45486a13a5","pubkey":"379e863e8357163b5bce5d2688dc4f1dcc2d505222fb8d74db600f30535dfdfe","created_at":1612809991,"kind":1,"tags":[],"content":"}]{","sig":"273a9cd5d11455590f4359500bccb7a89428262b96b3ea87a756b770964472f8c3e87f5d5e64d8d2e859a71462a3f477b554565c4f2f326cb01dd7620db71502"} ]"#;
+
+        match RelayMessage::from_json(msg)? {
+            RelayMessage::Event(subid, ev) => {
+                assert_eq!(subid, "sub\"id");
+                assert_eq!(ev.content, "}]{");
+            }
+            other => panic!("expected event, got {:?}", other),
+        }
+
+        Ok(())
+    }
+
+    #[test]
+    fn test_handle_trailing_garbage() {
+        assert_eq!(
+            RelayMessage::from_json(r#"["EOSE","subid"] extra"#).unwrap_err(),
+            Error::MessageDecodeFailed
+        );
+    }
+
     #[test]
     fn test_handle_valid_eose() -> Result<()> {
         let valid_eose_msg = r#"["EOSE","random-subscription-id"]"#;
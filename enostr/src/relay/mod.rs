@@ -6,8 +6,9 @@ use std::hash::{Hash, Hasher};
 
 pub mod message;
 pub mod pool;
+pub mod seen;
 
-#[derive(Debug)]
+#[derive(Debug, PartialEq, Eq)]
 pub enum RelayStatus {
     Connected,
     Connecting,
@@ -59,8 +60,13 @@ impl Relay {
     }
 
     pub fn send(&mut self, msg: &ClientMessage) {
-        let txt = WsMessage::Text(msg.to_json());
-        self.sender.send(txt);
+        self.send_raw(msg.to_json());
+    }
+
+    /// Send already-serialized message json, so a pool broadcast can
+    /// serialize once instead of once per relay.
+    pub fn send_raw(&mut self, json: String) {
+        self.sender.send(WsMessage::Text(json));
     }
 
     pub fn connect(&mut self, wakeup: impl Fn() + Send + Sync + 'static) -> Result<()> {
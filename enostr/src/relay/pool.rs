@@ -1,11 +1,12 @@
+use crate::metrics;
 use crate::relay::message::RelayEvent;
+use crate::relay::seen::{extract_created_at, extract_event_id, SeenIds};
 use crate::relay::{Relay, RelayStatus};
-use crate::{ClientMessage, Result};
+use crate::{ClientMessage, Filter, Result};
 
 use std::time::{Duration, Instant};
 
-#[cfg(not(target_arch = "wasm32"))]
-use ewebsock::WsMessage;
+use ewebsock::{WsEvent, WsMessage};
 
 #[cfg(not(target_arch = "wasm32"))]
 use tracing::debug;
@@ -23,26 +24,75 @@ pub struct PoolRelay {
     pub last_ping: Instant,
     pub last_connect_attempt: Instant,
     pub retry_connect_after: Duration,
+    /// messages received from this relay; registered once, bumped
+    /// lock-free
+    pub msgs_received: std::sync::Arc<metrics::Counter>,
+    /// when the last keepalive ping went out, until its pong comes back
+    ping_sent: Option<Instant>,
+    /// smoothed ping round-trip in milliseconds
+    pub rtt_ms: Option<f32>,
+    /// how long the first frame took after our first send, milliseconds
+    pub first_response_ms: Option<f32>,
+    /// when that first send happened, until something comes back
+    req_sent: Option<Instant>,
+    /// nostr messages (not control frames) this relay has delivered
+    pub events_delivered: u64,
+    /// newest created_at this relay has delivered, for gap-filling
+    /// resubscriptions after a reconnect
+    pub last_seen_at: Option<u64>,
 }
 
 impl PoolRelay {
     pub fn new(relay: Relay) -> PoolRelay {
+        let msgs_received = metrics::relay_counter(&relay.url);
         PoolRelay {
             relay: relay,
             last_ping: Instant::now(),
             last_connect_attempt: Instant::now(),
             retry_connect_after: Self::initial_reconnect_duration(),
+            msgs_received,
+            ping_sent: None,
+            rtt_ms: None,
+            first_response_ms: None,
+            req_sent: None,
+            events_delivered: 0,
+            last_seen_at: None,
         }
     }
 
     pub fn initial_reconnect_duration() -> Duration {
         Duration::from_secs(2)
     }
+
+    /// Latency estimate for routing, lower is better. Measured ping rtt
+    /// when we have one, first-response latency as a fallback, and
+    /// relays we know nothing about sort last.
+    pub fn score(&self) -> f32 {
+        self.rtt_ms.or(self.first_response_ms).unwrap_or(f32::INFINITY)
+    }
+
+    /// Start the first-response clock if it isn't running and hasn't
+    /// already produced a measurement.
+    fn mark_sent(&mut self) {
+        if self.req_sent.is_none() && self.first_response_ms.is_none() {
+            self.req_sent = Some(Instant::now());
+        }
+    }
+}
+
+/// A subscription the pool keeps alive across reconnects.
+struct Subscription {
+    sub_id: String,
+    filters: Vec<Filter>,
 }
 
 pub struct RelayPool {
     pub relays: Vec<PoolRelay>,
     pub ping_rate: Duration,
+    seen: SeenIds,
+    /// active subscriptions, re-issued to a relay whenever its socket
+    /// (re)opens
+    subs: Vec<Subscription>,
 }
 
 impl RelayPool {
@@ -51,6 +101,27 @@ impl RelayPool {
         RelayPool {
             relays: vec![],
             ping_rate: Duration::from_secs(25),
+            seen: SeenIds::new(),
+            subs: vec![],
+        }
+    }
+
+    /// Track REQ/CLOSE traffic passing through the pool, so a relay
+    /// that drops and reconnects can be resubscribed without the app
+    /// replaying its startup flow.
+    fn record_sub(&mut self, cmd: &ClientMessage) {
+        match cmd {
+            ClientMessage::Req { sub_id, filters } => {
+                self.subs.retain(|s| &s.sub_id != sub_id);
+                self.subs.push(Subscription {
+                    sub_id: sub_id.clone(),
+                    filters: filters.clone(),
+                });
+            }
+            ClientMessage::Close { sub_id } => {
+                self.subs.retain(|s| &s.sub_id != sub_id);
+            }
+            ClientMessage::Event { .. } => {}
         }
     }
 
@@ -69,8 +140,57 @@ impl RelayPool {
     }
 
     pub fn send(&mut self, cmd: &ClientMessage) {
+        self.record_sub(cmd);
+
+        // serialize once; each relay just clones the finished bytes
+        let json = cmd.to_json();
         for relay in &mut self.relays {
-            relay.relay.send(cmd);
+            relay.mark_sent();
+            relay.relay.send_raw(json.clone());
+        }
+    }
+
+    /// Send a one-shot query to the fastest healthy relay instead of
+    /// broadcasting. Subscriptions should still go through [`send`];
+    /// this is for things like profile fetches where any single relay's
+    /// answer is enough and waiting on the slowest one helps nobody.
+    pub fn send_to_fastest(&mut self, cmd: &ClientMessage) {
+        self.record_sub(cmd);
+
+        let mut best: Option<usize> = None;
+        let mut best_score = f32::INFINITY;
+        let mut best_delivered = 0u64;
+
+        for (ix, relay) in self.relays.iter().enumerate() {
+            if relay.relay.status != RelayStatus::Connected {
+                continue;
+            }
+            let score = relay.score();
+            let better = match best {
+                None => true,
+                // unmeasured relays tie at infinity; prefer the one
+                // that has actually delivered the most
+                Some(_) => {
+                    score < best_score
+                        || (score == best_score && relay.events_delivered > best_delivered)
+                }
+            };
+            if better {
+                best = Some(ix);
+                best_score = score;
+                best_delivered = relay.events_delivered;
+            }
+        }
+
+        match best {
+            Some(ix) => {
+                let relay = &mut self.relays[ix];
+                relay.mark_sent();
+                relay.relay.send(cmd);
+            }
+            // nobody is connected right now; fall back to broadcast and
+            // let the reconnect loop deliver it
+            None => self.send(cmd),
         }
     }
 
@@ -107,6 +227,7 @@ impl RelayPool {
                         debug!("pinging {}", relay.relay.url);
                         relay.relay.ping();
                         relay.last_ping = Instant::now();
+                        relay.ping_sent = Some(relay.last_ping);
                     }
                 }
 
@@ -118,10 +239,12 @@ impl RelayPool {
     }
 
     pub fn send_to(&mut self, cmd: &ClientMessage, relay_url: &str) {
+        self.record_sub(cmd);
+
         for relay in &mut self.relays {
-            let relay = &mut relay.relay;
-            if relay.url == relay_url {
-                relay.send(cmd);
+            if relay.relay.url == relay_url {
+                relay.mark_sent();
+                relay.relay.send(cmd);
                 return;
             }
         }
@@ -143,13 +266,88 @@ impl RelayPool {
 
     /// Attempts to receive a pool event from a list of relays. The function searches each relay in the list in order, attempting to receive a message from each. If a message is received, return it. If no message is received from any relays, None is returned.
     pub fn try_recv(&mut self) -> Option<PoolEvent<'_>> {
-        for relay in &mut self.relays {
-            let relay = &mut relay.relay;
-            if let Some(msg) = relay.receiver.try_recv() {
+        let seen = &mut self.seen;
+        let subs = &self.subs;
+        for pool_relay in &mut self.relays {
+            let PoolRelay {
+                relay,
+                msgs_received,
+                ping_sent,
+                rtt_ms,
+                first_response_ms,
+                req_sent,
+                events_delivered,
+                last_seen_at,
+                ..
+            } = pool_relay;
+            // keep draining this relay when a frame is dropped below, so
+            // returning None really means nothing is queued anywhere --
+            // a run of duplicates from the slower relay must not stall
+            // the frames behind it
+            while let Some(msg) = relay.receiver.try_recv() {
+                metrics::RELAY_MESSAGES.incr();
+                msgs_received.incr();
+
+                if let Some(sent) = req_sent.take() {
+                    *first_response_ms = Some(sent.elapsed().as_secs_f32() * 1000.0);
+                }
+
+                // With multiple relays subscribed to the same filters,
+                // about half the frames are events we already have. Pull
+                // the id out of the raw frame and drop duplicates here,
+                // before paying for a full parse. When extraction can't
+                // find an unambiguous id we just parse as before.
+                if let WsEvent::Message(WsMessage::Text(ref txt)) = msg {
+                    // track the newest timestamp this relay has handed
+                    // us, duplicates included -- a reconnect only needs
+                    // to backfill from here
+                    if let Some(at) = extract_created_at(txt) {
+                        if Some(at) > *last_seen_at {
+                            *last_seen_at = Some(at);
+                        }
+                    }
+
+                    if let Some(id) = extract_event_id(txt) {
+                        if !seen.insert(id) {
+                            metrics::DUP_FRAMES_DROPPED.incr();
+                            continue;
+                        }
+                    }
+                }
+
+                #[cfg(not(target_arch = "wasm32"))]
+                let parse_start = Instant::now();
+
                 match msg.try_into() {
                     Ok(event) => {
+                        #[cfg(not(target_arch = "wasm32"))]
+                        metrics::PARSE_NS.record_ns(parse_start.elapsed().as_nanos() as u64);
+
                         relay.status = RelayStatus::Connected;
-                        // let's just handle pongs here.
+
+                        // a fresh socket has no server-side state:
+                        // replay every active subscription, with live
+                        // ones asking only for what this relay may have
+                        // missed while it was down
+                        if let RelayEvent::Opened = event {
+                            for sub in subs.iter() {
+                                let filters = sub
+                                    .filters
+                                    .iter()
+                                    .map(|f| match *last_seen_at {
+                                        Some(at) if f.is_live() => f.gap_fill(at),
+                                        _ => f.clone(),
+                                    })
+                                    .collect();
+                                relay.send(&ClientMessage::req(sub.sub_id.clone(), filters));
+                            }
+                        }
+
+                        if let RelayEvent::Message(_) = event {
+                            *events_delivered += 1;
+                        }
+
+                        // let's just handle pings/pongs here.
                         // We only need to do this natively.
                         #[cfg(not(target_arch = "wasm32"))]
                         match event {
@@ -157,6 +355,19 @@ impl RelayPool {
                                 debug!("pong {}", &relay.url);
                                 relay.sender.send(WsMessage::Pong(bs.to_owned()));
                             }
+                            RelayEvent::Other(WsMessage::Pong(_)) => {
+                                if let Some(sent) = ping_sent.take() {
+                                    let ms = sent.elapsed().as_secs_f32() * 1000.0;
+                                    // exponential moving average; one
+                                    // slow moment on a relay shouldn't
+                                    // dominate routing for long
+                                    *rtt_ms = Some(match *rtt_ms {
+                                        Some(prev) => prev * 0.7 + ms * 0.3,
+                                        None => ms,
+                                    });
+                                    debug!("rtt {} {:.1}ms", &relay.url, ms);
+                                }
+                            }
                             _ => {}
                         }
 
@@ -167,6 +378,7 @@ impl RelayPool {
                     }
 
                     Err(e) => {
+                        metrics::PARSE_ERRORS.incr();
                         relay.status = RelayStatus::Disconnected;
                         error!("try_recv {:?}", e);
                         continue;
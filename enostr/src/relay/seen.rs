@@ -0,0 +1,204 @@
+use crate::{hex, EventId};
+use std::collections::HashSet;
+
+/// Bloom filter size in bits. 64 KiB of bits keeps the false positive
+/// rate tiny for a session's worth of events, and a false positive only
+/// costs one extra hash-set lookup anyway.
+const BLOOM_BITS: usize = 1 << 19;
+
+/// Event ids we've already pulled off some relay this session. With more
+/// than one relay configured, most frames are duplicates, so membership
+/// checks need to be cheaper than parsing: a bloom filter answers
+/// "definitely new" from two bit probes, and an exact set confirms the
+/// positives so a collision can never drop a fresh event.
+///
+/// Event ids are sha256 outputs, so slices of the id itself serve as the
+/// bloom hashes; nothing needs rehashing.
+pub struct SeenIds {
+    bits: Vec<u64>,
+    exact: HashSet<EventId>,
+}
+
+impl SeenIds {
+    pub fn new() -> Self {
+        SeenIds {
+            bits: vec![0; BLOOM_BITS / 64],
+            exact: HashSet::new(),
+        }
+    }
+
+    fn bit_indexes(id: &EventId) -> (usize, usize) {
+        let bytes = id.bytes();
+        let h1 = u64::from_le_bytes(bytes[0..8].try_into().unwrap());
+        let h2 = u64::from_le_bytes(bytes[8..16].try_into().unwrap());
+        (
+            (h1 as usize) % BLOOM_BITS,
+            (h2 as usize) % BLOOM_BITS,
+        )
+    }
+
+    /// Record an id. Returns false if it was already seen.
+    pub fn insert(&mut self, id: EventId) -> bool {
+        let (b1, b2) = Self::bit_indexes(&id);
+        let fresh = self.bits[b1 / 64] & (1 << (b1 % 64)) == 0
+            || self.bits[b2 / 64] & (1 << (b2 % 64)) == 0;
+
+        self.bits[b1 / 64] |= 1 << (b1 % 64);
+        self.bits[b2 / 64] |= 1 << (b2 % 64);
+
+        if fresh {
+            self.exact.insert(id);
+            true
+        } else {
+            // bloom says maybe; the exact set decides
+            self.exact.insert(id)
+        }
+    }
+}
+
+/// Cheaply pull the event id out of a raw `["EVENT",...]` frame without
+/// parsing it. Only matches the compact `"id":"<64 hex>"` form relays
+/// actually send, and gives up when the match isn't unique (an id quoted
+/// inside note content, say). Returning None just means the caller pays
+/// for a normal parse, so false negatives are fine and false positives
+/// are not.
+pub fn extract_event_id(frame: &str) -> Option<EventId> {
+    let rest = frame.trim_start().strip_prefix('[')?;
+    rest.trim_start().strip_prefix("\"EVENT\"")?;
+
+    const NEEDLE: &[u8] = b"\"id\":\"";
+    let bytes = frame.as_bytes();
+    let mut found: Option<EventId> = None;
+
+    let mut i = 0;
+    while i + NEEDLE.len() + 65 <= bytes.len() {
+        if &bytes[i..i + NEEDLE.len()] != NEEDLE {
+            i += 1;
+            continue;
+        }
+        let start = i + NEEDLE.len();
+        if bytes[start + 64] == b'"' {
+            if let Some(id) = hex::decode_exact(&frame[start..start + 64]) {
+                let id = EventId::new(id);
+                if found.is_some() {
+                    return None;
+                }
+                found = Some(id);
+            }
+        }
+        i = start;
+    }
+
+    found
+}
+
+/// Cheaply pull `created_at` out of a raw `["EVENT",...]` frame, with
+/// the same rules as [`extract_event_id`]: only the compact form relays
+/// actually send, and give up when the match isn't unique. The pool uses
+/// this to remember the newest timestamp each relay has delivered, so a
+/// reconnect can ask only for what was missed; a None here just means
+/// one reconnect refetches a little more than it had to.
+pub fn extract_created_at(frame: &str) -> Option<u64> {
+    let rest = frame.trim_start().strip_prefix('[')?;
+    rest.trim_start().strip_prefix("\"EVENT\"")?;
+
+    const NEEDLE: &[u8] = b"\"created_at\":";
+    let bytes = frame.as_bytes();
+    let mut found: Option<u64> = None;
+
+    let mut i = 0;
+    while i + NEEDLE.len() < bytes.len() {
+        if &bytes[i..i + NEEDLE.len()] != NEEDLE {
+            i += 1;
+            continue;
+        }
+        let start = i + NEEDLE.len();
+        let mut end = start;
+        while end < bytes.len() && bytes[end].is_ascii_digit() {
+            end += 1;
+        }
+        if end > start {
+            if let Ok(at) = frame[start..end].parse::<u64>() {
+                if found.is_some() {
+                    return None;
+                }
+                found = Some(at);
+            }
+        }
+        i = start;
+    }
+
+    found
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const ID: &str = "f00db15ca117bea7f4b3a1e93d4bbefcf264b5dde8e93f826ce85b2a18f4c0ff";
+
+    #[test]
+    fn test_extracts_plain_frame() {
+        let frame = format!(
+            r#"["EVENT","sub",{{"id":"{}","kind":1,"content":"hi"}}]"#,
+            ID
+        );
+        assert_eq!(extract_event_id(&frame), Some(EventId::from_hex(ID).unwrap()));
+    }
+
+    #[test]
+    fn test_escaped_id_in_content_is_ignored() {
+        // quotes inside content are escaped, so they can't match the
+        // compact "id":" needle
+        let frame = format!(
+            r#"["EVENT","sub",{{"id":"{}","content":"evil: \"id\":\"{}\""}}]"#,
+            ID, ID
+        );
+        assert_eq!(extract_event_id(&frame), Some(EventId::from_hex(ID).unwrap()));
+    }
+
+    #[test]
+    fn test_ambiguous_frame_falls_back() {
+        let other = "1111111111111111111111111111111111111111111111111111111111111111";
+        let frame = format!(
+            r#"["EVENT","sub",{{"id":"{}","extra":{{"id":"{}"}}}}]"#,
+            ID, other
+        );
+        assert_eq!(extract_event_id(&frame), None);
+    }
+
+    #[test]
+    fn test_non_event_frames_skip() {
+        assert_eq!(extract_event_id(r#"["EOSE","sub"]"#), None);
+        assert_eq!(extract_event_id(r#"["NOTICE","id"]"#), None);
+    }
+
+    #[test]
+    fn test_extracts_created_at() {
+        let frame = format!(
+            r#"["EVENT","sub",{{"id":"{}","created_at":1700000000,"content":"hi"}}]"#,
+            ID
+        );
+        assert_eq!(extract_created_at(&frame), Some(1700000000));
+    }
+
+    #[test]
+    fn test_ambiguous_created_at_falls_back() {
+        let frame = format!(
+            r#"["EVENT","sub",{{"id":"{}","created_at":1,"extra":{{"created_at":2}}}}]"#,
+            ID
+        );
+        assert_eq!(extract_created_at(&frame), None);
+        assert_eq!(extract_created_at(r#"["EOSE","sub"]"#), None);
+    }
+
+    #[test]
+    fn test_seen_ids_dedup() {
+        let mut seen = SeenIds::new();
+        let a = EventId::new([1; 32]);
+        let b = EventId::new([2; 32]);
+        assert!(seen.insert(a));
+        assert!(!seen.insert(a));
+        assert!(seen.insert(b));
+    }
+}
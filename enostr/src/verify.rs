@@ -0,0 +1,94 @@
+use crate::{sha256, Error, Event, Result};
+use secp256k1::{schnorr, Message, Secp256k1, VerifyOnly, XOnlyPublicKey};
+use std::sync::OnceLock;
+
+/// One shared verification-only context. Building a secp context is
+/// expensive; verifying against it is not, and it is Sync, so every
+/// thread can share it.
+fn secp() -> &'static Secp256k1<VerifyOnly> {
+    static SECP: OnceLock<Secp256k1<VerifyOnly>> = OnceLock::new();
+    SECP.get_or_init(Secp256k1::verification_only)
+}
+
+/// Compute the canonical nostr event id: the sha256 of the NIP-01
+/// serialization [0, pubkey, created_at, kind, tags, content]. Serialized
+/// as a tuple so serde streams it straight into a string without
+/// building a Value tree first.
+pub fn event_id(ev: &Event) -> [u8; 32] {
+    let canonical = serde_json::to_string(&(
+        0u32,
+        ev.pubkey.hex(),
+        ev.created_at,
+        ev.kind,
+        &ev.tags,
+        &ev.content,
+    ))
+    .expect("canonical event serialization");
+    sha256::hash(canonical.as_bytes())
+}
+
+/// Check that an event's id matches its contents and that the schnorr
+/// signature over that id is valid for the claimed pubkey.
+pub fn verify_event(ev: &Event) -> Result<()> {
+    if &event_id(ev) != ev.id.bytes() {
+        return Err(Error::InvalidEventId);
+    }
+
+    let msg = Message::from_slice(ev.id.bytes()).map_err(|_| Error::InvalidSignature)?;
+    let pubkey =
+        XOnlyPublicKey::from_slice(ev.pubkey.bytes()).map_err(|_| Error::InvalidSignature)?;
+    let sig = schnorr::Signature::from_slice(ev.sig.bytes()).map_err(|_| Error::InvalidSignature)?;
+
+    secp()
+        .verify_schnorr(&sig, &msg, &pubkey)
+        .map_err(|_| Error::InvalidSignature)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::hex;
+
+    fn valid_event() -> Event {
+        // same vector as the relay message tests
+        Event::new_dummy(
+            "70b10f70c1318967eddf12527799411b1a9780ad9c43858f5e5fcd45486a13a5",
+            "379e863e8357163b5bce5d2688dc4f1dcc2d505222fb8d74db600f30535dfdfe",
+            1612809991,
+            1,
+            vec![],
+            "test",
+            "273a9cd5d11455590f4359500bccb7a89428262b96b3ea87a756b770964472f8c3e87f5d5e64d8d2e859a71462a3f477b554565c4f2f326cb01dd7620db71502",
+        )
+        .expect("dummy event")
+    }
+
+    #[test]
+    fn test_valid_event_verifies() {
+        assert!(verify_event(&valid_event()).is_ok());
+    }
+
+    #[test]
+    fn test_tampered_content_is_rejected() {
+        let mut ev = valid_event();
+        ev.content = "test!".to_string();
+        assert_eq!(verify_event(&ev), Err(Error::InvalidEventId));
+    }
+
+    #[test]
+    fn test_tampered_sig_is_rejected() {
+        let mut ev = valid_event();
+        let mut sig = *ev.sig.bytes();
+        sig[0] ^= 1;
+        ev.sig = crate::Sig::new(sig);
+        assert_eq!(verify_event(&ev), Err(Error::InvalidSignature));
+    }
+
+    #[test]
+    fn test_event_id_matches_vector() {
+        assert_eq!(
+            hex::encode(&event_id(&valid_event())),
+            "70b10f70c1318967eddf12527799411b1a9780ad9c43858f5e5fcd45486a13a5"
+        );
+    }
+}
@@ -1,22 +1,32 @@
 use crate::abbrev;
+use crate::atlas::AtlasHandle;
 use crate::contacts::Contacts;
+use crate::events::EventArena;
 use crate::fonts::{setup_fonts, setup_gossip_fonts};
 use crate::frame_history::FrameHistory;
 use crate::images::fetch_img;
+use crate::ingest::{Ingest, IngestItem};
+use crate::storage::EventStore;
+use crate::timeline::{NoteRef, Timeline, TimelineFilter};
 use crate::ui::padding;
 use crate::Result;
 use egui::containers::scroll_area::ScrollBarVisibility;
+use egui::text::LayoutJob;
 use egui::widgets::Spinner;
-use egui::{Context, Frame, Margin, TextureHandle, TextureId};
+use egui::{Context, Frame, Galley, Margin};
 use egui_extras::Size;
-use enostr::{ClientMessage, EventId, Filter, Profile, Pubkey, RelayEvent, RelayMessage};
+use enostr::note::{Block, Mention};
+use enostr::{
+    ClientMessage, EventId, Filter, Note, Profile, Pubkey, RelayEvent, RelayMessage, Sig,
+};
 use poll_promise::Promise;
-use std::collections::{HashMap, HashSet};
+use std::collections::{HashMap, HashSet, VecDeque};
 use std::hash::{Hash, Hasher};
+use std::sync::Arc;
 use std::time::Duration;
-use tracing::{debug, error, info, warn};
+use tracing::{debug, info, warn};
 
-use enostr::{Event, RelayPool};
+use enostr::Event;
 
 #[derive(Hash, Eq, PartialEq, Clone, Debug)]
 enum UrlKey<'a> {
@@ -32,7 +42,134 @@ impl UrlKey<'_> {
     }
 }
 
-type ImageCache = HashMap<u64, Promise<Result<TextureHandle>>>;
+type ImageCache = HashMap<u64, Promise<Result<AtlasHandle>>>;
+
+/// Starting guess for a note's height until we've measured one.
+const DEFAULT_NOTE_HEIGHT: f32 = 80.0;
+
+/// Layout state for the virtualized timeline: measured per-note heights,
+/// plus enough bookkeeping to keep the scroll position anchored when new
+/// notes arrive above the visible window.
+struct ViewState {
+    heights: HashMap<EventId, f32>,
+    height_sum: f32,
+    last_width: f32,
+    /// Pre-shaped note bodies, keyed by note id and dark mode. Shaping
+    /// and wrapping text is the top render cost for long notes, so in
+    /// the steady state a visible note paints a cached galley instead of
+    /// re-laying-out its content every frame.
+    galleys: HashMap<(EventId, bool), Arc<Galley>>,
+    /// first visible note last frame
+    anchor: Option<NoteRef>,
+    /// notes inserted above the anchor since the last frame
+    inserted_above: usize,
+    /// scroll offset to apply on the next frame to keep the anchor still
+    scroll_to: Option<f32>,
+}
+
+impl ViewState {
+    fn new() -> Self {
+        ViewState {
+            heights: HashMap::new(),
+            height_sum: 0.0,
+            last_width: 0.0,
+            galleys: HashMap::new(),
+            anchor: None,
+            inserted_above: 0,
+            scroll_to: None,
+        }
+    }
+
+    fn estimated_height(&self) -> f32 {
+        if self.heights.is_empty() {
+            DEFAULT_NOTE_HEIGHT
+        } else {
+            self.height_sum / self.heights.len() as f32
+        }
+    }
+
+    fn height_of(&self, id: &EventId) -> f32 {
+        self.heights
+            .get(id)
+            .copied()
+            .unwrap_or_else(|| self.estimated_height())
+    }
+
+    fn record_height(&mut self, id: EventId, height: f32) {
+        match self.heights.insert(id, height) {
+            Some(old) => self.height_sum += height - old,
+            None => self.height_sum += height,
+        }
+    }
+
+    /// Wipe measurements and shaped text when the panel width changes;
+    /// wrapping changes every height and every galley.
+    fn check_width(&mut self, width: f32) {
+        if (width - self.last_width).abs() > 1.0 {
+            self.heights.clear();
+            self.height_sum = 0.0;
+            self.galleys.clear();
+            self.last_width = width;
+        }
+    }
+
+    /// The shaped galley for a note body, laid out at the current wrap
+    /// width from its pre-shattered blocks. Cached until the panel is
+    /// resized or the theme flips.
+    fn note_galley(
+        &mut self,
+        ui: &egui::Ui,
+        id: EventId,
+        content: &str,
+        note: Option<&Note>,
+    ) -> Arc<Galley> {
+        let dark = ui.visuals().dark_mode;
+        if let Some(galley) = self.galleys.get(&(id, dark)) {
+            return galley.clone();
+        }
+
+        let body = egui::TextStyle::Body.resolve(ui.style());
+        let text_color = ui.visuals().text_color();
+        let link_color = ui.visuals().hyperlink_color;
+
+        let mut job = LayoutJob::default();
+        job.wrap.max_width = ui.available_width();
+
+        match note {
+            None => job.append(content, 0.0, egui::TextFormat::simple(body, text_color)),
+            Some(note) => {
+                for block in &note.blocks {
+                    let (text, color): (&str, _) = match block {
+                        Block::Text(r) => (&content[r.clone()], text_color),
+                        Block::Url(r) => (&content[r.clone()], link_color),
+                        Block::Hashtag(r) => (&content[r.clone()], link_color),
+                        Block::Mention(Mention::Pubkey(pk)) => {
+                            job.append(
+                                &format!("@{}…", &pk.hex()[..8]),
+                                0.0,
+                                egui::TextFormat::simple(body.clone(), link_color),
+                            );
+                            continue;
+                        }
+                        Block::Mention(Mention::Event(evid)) => {
+                            job.append(
+                                &format!("&{}…", &evid.hex()[..8]),
+                                0.0,
+                                egui::TextFormat::simple(body.clone(), link_color),
+                            );
+                            continue;
+                        }
+                    };
+                    job.append(text, 0.0, egui::TextFormat::simple(body.clone(), color));
+                }
+            }
+        }
+
+        let galley = ui.fonts(|f| f.layout_job(job));
+        self.galleys.insert((id, dark), galley.clone());
+        galley
+    }
+}
 
 #[derive(Eq, PartialEq, Clone)]
 pub enum DamusState {
@@ -40,17 +177,117 @@ pub enum DamusState {
     Initialized,
 }
 
+/// One timeline column: its filter, the materialized index of matching
+/// notes, and its own layout and scroll state. New events are evaluated
+/// against every panel's filter once at ingest; nothing ever filters the
+/// full event set at render time.
+struct Panel {
+    filter: TimelineFilter,
+    /// what's typed in the panel's filter box, parsed into `filter`
+    filter_input: String,
+    timeline: Timeline,
+    view_state: ViewState,
+}
+
+impl Panel {
+    fn new() -> Self {
+        Panel {
+            filter: TimelineFilter::default(),
+            filter_input: String::new(),
+            timeline: Timeline::new(),
+            view_state: ViewState::new(),
+        }
+    }
+}
+
+/// How much history one backfill REQ asks for. Windows widen when they
+/// come back empty, so quiet stretches don't cost a round trip per day.
+const BACKFILL_WINDOW_SECS: u64 = 60 * 60 * 24;
+const BACKFILL_MAX_WINDOW_SECS: u64 = 60 * 60 * 24 * 32;
+
+/// Give up paging after this many consecutive empty windows; we're
+/// past the beginning of the feed.
+const BACKFILL_GIVE_UP_EMPTY: u32 = 8;
+
+/// Windowed history pagination. The initial subscription only carries
+/// the newest notes and stays open for live events; deep history is
+/// fetched one bounded until/since slice at a time, the next slice
+/// triggered by scrolling near the bottom, so backfill never arrives as
+/// one unbounded EOSE burst.
+struct Backfill {
+    /// inclusive upper bound of the next window; seeded from the oldest
+    /// note we have once the initial subscription reaches EOSE
+    until: Option<u64>,
+    /// lower bound of the window currently in flight
+    req_since: u64,
+    window: u64,
+    in_flight: bool,
+    /// event count when the in-flight window was sent, to detect empty
+    /// windows without tracking ids per window
+    events_at_send: usize,
+    empty_windows: u32,
+    done: bool,
+}
+
+impl Backfill {
+    fn new() -> Self {
+        Backfill {
+            until: None,
+            req_since: 0,
+            window: BACKFILL_WINDOW_SECS,
+            in_flight: false,
+            events_at_send: 0,
+            empty_windows: 0,
+            done: false,
+        }
+    }
+}
+
 /// We derive Deserialize/Serialize so we can persist app state on shutdown.
 pub struct Damus {
     state: DamusState,
     contacts: Contacts,
-    n_panels: u32,
+    panels: Vec<Panel>,
     compose: String,
 
-    pool: RelayPool,
+    /// Relay ingest, owned by a background thread on native. None until
+    /// the first frame, since its wakeup callback needs the egui context.
+    ingest: Option<Ingest>,
 
-    all_events: HashMap<EventId, Event>,
-    events: Vec<EventId>,
+    all_events: EventArena,
+
+    /// Precomputed render structure per kind-1 event, shattered at
+    /// ingest so render never walks tags or rescans content.
+    notes: HashMap<EventId, Note>,
+
+    /// Persistent append-only event log. None when persistence is
+    /// unavailable (wasm, or the data dir could not be opened).
+    store: Option<EventStore>,
+
+    /// Authors we've seen notes from but have no profile for yet,
+    /// maintained incrementally at ingest so EOSE handling never has to
+    /// scan the full event map.
+    pending_authors: HashSet<Pubkey>,
+
+    /// Authors we've already asked a relay for, so multiple relays
+    /// reaching EOSE don't all get the same profile batch request.
+    requested_authors: HashSet<Pubkey>,
+
+    /// Ingest work carried over from frames whose budget ran out. Items
+    /// for the visible timeline subscription drain before backfill, so
+    /// the on-screen feed stays live while history churns through.
+    pending_visible: VecDeque<IngestItem>,
+    pending_backfill: VecDeque<IngestItem>,
+
+    backfill: Backfill,
+
+    /// whether the feed REQ has been seeded into the relay pool; the
+    /// pool itself resubscribes relays that drop and reconnect
+    subscribed: bool,
+
+    /// created_at of the oldest kind-1 note we hold, maintained at
+    /// ingest; each backfill window starts where our history ends
+    oldest_note_at: Option<u64>,
 
     img_cache: ImageCache,
 
@@ -62,11 +299,19 @@ impl Default for Damus {
         Self {
             state: DamusState::Initializing,
             contacts: Contacts::new(),
-            all_events: HashMap::new(),
-            pool: RelayPool::new(),
-            events: vec![],
+            all_events: EventArena::new(),
+            notes: HashMap::new(),
+            ingest: None,
+            store: None,
+            pending_authors: HashSet::new(),
+            requested_authors: HashSet::new(),
+            pending_visible: VecDeque::new(),
+            pending_backfill: VecDeque::new(),
+            backfill: Backfill::new(),
+            subscribed: false,
+            oldest_note_at: None,
             img_cache: HashMap::new(),
-            n_panels: 1,
+            panels: vec![Panel::new()],
             compose: "".to_string(),
             frame_history: FrameHistory::default(),
         }
@@ -79,32 +324,115 @@ pub fn is_mobile(ctx: &egui::Context) -> bool {
     screen_size.x < 550.0
 }
 
-fn relay_setup(pool: &mut RelayPool, ctx: &egui::Context) {
-    let ctx = ctx.clone();
-    let wakeup = move || {
-        ctx.request_repaint();
-    };
-    if let Err(e) = pool.add_url("wss://relay.damus.io".to_string(), wakeup.clone()) {
-        error!("{:?}", e)
+fn relay_setup(ingest: &mut Ingest) {
+    ingest.add_url("wss://relay.damus.io".to_string());
+    ingest.add_url("wss://purplepag.es".to_string());
+}
+
+/// The feed we follow; both the live subscription and backfill windows
+/// are slices of this.
+fn feed_filter() -> Filter {
+    let pubkey =
+        Pubkey::from_hex("32e1827635450ebb3c5a7d12c1f8e7b2b514439ac10a67eef3d9fd9c5c68e245")
+            .expect("pubkey");
+    Filter::new().kinds(vec![1, 42]).pubkeys(vec![pubkey])
+}
+
+/// Seed the feed subscription into the pool. Broadcast once; the pool
+/// records it and re-issues it (gap-filled) to every relay whose socket
+/// opens after this, including reconnects.
+fn send_initial_filters(damus: &mut Damus) {
+    let filter = feed_filter().limit(100);
+
+    let subid = "initial";
+    if let Some(ingest) = &mut damus.ingest {
+        ingest.send(ClientMessage::req(subid.to_string(), vec![filter]));
+    }
+}
+
+/// Ask for the next history window if the user is near the bottom and
+/// nothing is already in flight. Windows walk backwards from the oldest
+/// note we hold, so each REQ is a bounded slice that merges into the
+/// timeline incrementally instead of one giant limit-N burst.
+fn maybe_request_backfill(damus: &mut Damus) {
+    if damus.backfill.in_flight || damus.backfill.done {
+        return;
     }
-    if let Err(e) = pool.add_url("wss://purplepag.es".to_string(), wakeup) {
-        error!("{:?}", e)
+
+    let until = match damus.backfill.until {
+        Some(until) => until,
+        // not seeded yet: wait until the initial subscription has given
+        // us an oldest note to page back from
+        None => match damus.oldest_note_at {
+            Some(at) => at.saturating_sub(1),
+            None => return,
+        },
+    };
+
+    let since = until.saturating_sub(damus.backfill.window);
+    let filter = feed_filter().since(since).until(until);
+
+    damus.backfill.until = Some(until);
+    damus.backfill.req_since = since;
+    damus.backfill.in_flight = true;
+    damus.backfill.events_at_send = damus.all_events.len();
+
+    debug!("backfill window {}..{}", since, until);
+    if let Some(ingest) = &mut damus.ingest {
+        // broadcast: history is the union of what each relay kept
+        ingest.send(ClientMessage::req("backfill".to_string(), vec![filter]));
     }
 }
 
-fn send_initial_filters(pool: &mut RelayPool, relay_url: &str) {
-    let filter = Filter::new().limit(100).kinds(vec![1, 42]).pubkeys(
-        ["32e1827635450ebb3c5a7d12c1f8e7b2b514439ac10a67eef3d9fd9c5c68e245".into()].into(),
-    );
+/// A backfill window finished on some relay. Close it out, widen the
+/// window if it came back empty, and line up the next slice; the scroll
+/// trigger decides when to actually send it.
+fn handle_backfill_eose(damus: &mut Damus) {
+    if !damus.backfill.in_flight {
+        // a slower relay's EOSE for a window we already closed
+        return;
+    }
+    damus.backfill.in_flight = false;
 
-    let subid = "initial";
-    for relay in &mut pool.relays {
-        let relay = &mut relay.relay;
-        if relay.url == relay_url {
-            relay.subscribe(subid.to_string(), vec![filter]);
-            return;
+    if let Some(ingest) = &mut damus.ingest {
+        ingest.send(ClientMessage::close("backfill".to_string()));
+    }
+
+    if damus.all_events.len() > damus.backfill.events_at_send {
+        damus.backfill.empty_windows = 0;
+        damus.backfill.window = BACKFILL_WINDOW_SECS;
+    } else {
+        damus.backfill.empty_windows += 1;
+        damus.backfill.window = (damus.backfill.window * 2).min(BACKFILL_MAX_WINDOW_SECS);
+        if damus.backfill.empty_windows >= BACKFILL_GIVE_UP_EMPTY {
+            info!("backfill: reached the start of the feed");
+            damus.backfill.done = true;
         }
     }
+
+    damus.backfill.until = Some(damus.backfill.req_since.saturating_sub(1));
+}
+
+/// How long one frame may spend applying ingested items before carrying
+/// the rest over to the next frame. Reconnecting after laptop sleep can
+/// queue thousands of messages; the budget keeps worst-case frame time
+/// bounded no matter how deep the backlog is.
+#[cfg(not(target_arch = "wasm32"))]
+const INGEST_FRAME_BUDGET: Duration = Duration::from_millis(2);
+
+/// std::time::Instant panics on wasm, so the budget there is an item
+/// count instead of a time slice.
+#[cfg(target_arch = "wasm32")]
+const INGEST_FRAME_ITEMS: usize = 256;
+
+/// Backfill traffic can wait a frame or two; anything on the visible
+/// timeline subscription (and all connection control events) cannot.
+fn is_backfill(item: &IngestItem) -> bool {
+    match &item.event {
+        RelayEvent::Message(RelayMessage::Event(subid, _)) => subid != "initial",
+        RelayEvent::Message(RelayMessage::Eose(subid)) => subid != "initial",
+        _ => false,
+    }
 }
 
 fn try_process_event(damus: &mut Damus, ctx: &egui::Context) {
@@ -115,25 +443,102 @@ fn try_process_event(damus: &mut Damus, ctx: &egui::Context) {
         ctx.set_pixels_per_point(ctx.pixels_per_point() - amount);
     }
 
-    let ctx2 = ctx.clone();
-    let wakeup = move || {
-        ctx2.request_repaint();
-    };
-    damus.pool.keepalive_ping(wakeup);
+    // Pull everything the ingest thread has ready into the carry-over
+    // queues. This is just moving boxes; the per-item work below is what
+    // the budget meters.
+    loop {
+        let batch = match &mut damus.ingest {
+            Some(ingest) => ingest.try_recv_batch(),
+            None => None,
+        };
+
+        let batch = match batch {
+            Some(batch) => batch,
+            None => break,
+        };
+
+        for item in batch {
+            if is_backfill(&item) {
+                damus.pending_backfill.push_back(item);
+            } else {
+                damus.pending_visible.push_back(item);
+            }
+        }
 
-    // pool stuff
-    while let Some(ev) = damus.pool.try_recv() {
-        let relay = ev.relay.to_owned();
+        // On wasm, try_recv_batch parses and schnorr-verifies inline on
+        // the browser main thread, so looping until None would burn a
+        // whole reconnect backlog in one frame. Take one frame-sized
+        // batch and come back for the rest next frame.
+        #[cfg(target_arch = "wasm32")]
+        {
+            ctx.request_repaint();
+            break;
+        }
+    }
 
-        match ev.event {
-            RelayEvent::Opened => send_initial_filters(&mut damus.pool, &relay),
-            // TODO: handle reconnects
+    // spend the frame's ingest budget, visible subscription first
+    #[cfg(not(target_arch = "wasm32"))]
+    let started_at = std::time::Instant::now();
+    let mut processed: usize = 0;
+
+    loop {
+        let item = match damus.pending_visible.pop_front() {
+            Some(item) => Some(item),
+            None => damus.pending_backfill.pop_front(),
+        };
+        let item = match item {
+            Some(item) => item,
+            None => break,
+        };
+
+        #[cfg(not(target_arch = "wasm32"))]
+        let item_started_at = std::time::Instant::now();
+
+        let IngestItem { relay, event, note } = item;
+        match event {
+            // the pool resubscribes (re)opened relays itself, gap-filled
+            // from the last event each one delivered; we only seed the
+            // feed REQ on the first open
+            RelayEvent::Opened => {
+                if !damus.subscribed {
+                    damus.subscribed = true;
+                    send_initial_filters(damus);
+                }
+            }
             RelayEvent::Closed => warn!("{} connection closed", &relay),
             RelayEvent::Other(msg) => debug!("other event {:?}", &msg),
-            RelayEvent::Message(msg) => process_message(damus, &relay, msg),
+            RelayEvent::Message(msg) => process_message(damus, &relay, msg, note),
+        }
+        processed += 1;
+        crate::metrics::INGEST_ITEMS.incr();
+        #[cfg(not(target_arch = "wasm32"))]
+        crate::metrics::INGEST_ITEM_NS.record_ns(item_started_at.elapsed().as_nanos() as u64);
+
+        #[cfg(not(target_arch = "wasm32"))]
+        let spent = started_at.elapsed() >= INGEST_FRAME_BUDGET;
+        #[cfg(target_arch = "wasm32")]
+        let spent = processed >= INGEST_FRAME_ITEMS;
+        if spent {
+            break;
         }
     }
-    //info!("recv {:?}", ev)
+
+    #[cfg(not(target_arch = "wasm32"))]
+    damus
+        .frame_history
+        .record_ingest(started_at.elapsed().as_secs_f32());
+
+    crate::metrics::set_queue_depth(damus.pending_visible.len() + damus.pending_backfill.len());
+
+    // whatever we couldn't afford this frame gets the next one
+    if !damus.pending_visible.is_empty() || !damus.pending_backfill.is_empty() {
+        debug!(
+            "ingest budget hit after {} items, {} carried over",
+            processed,
+            damus.pending_visible.len() + damus.pending_backfill.len()
+        );
+        ctx.request_repaint();
+    }
 }
 
 #[cfg(feature = "profiling")]
@@ -141,44 +546,109 @@ fn setup_profiling() {
     puffin::set_scopes_on(true); // tell puffin to collect data
 }
 
+/// Open the on-disk event log and replay everything from previous
+/// sessions through the normal ingest path, so the timeline is populated
+/// before we've heard a single byte from a relay. `damus.store` is still
+/// None while we replay, which keeps `process_event` from appending the
+/// replayed events right back into the log.
+#[cfg(not(target_arch = "wasm32"))]
+fn setup_event_store(damus: &mut Damus) {
+    match EventStore::open() {
+        Err(e) => {
+            warn!("could not open event store: {:?}", e);
+        }
+        Ok((store, events)) => {
+            let n_events = events.len();
+            for ev in events {
+                process_event(damus, "store", ev, None);
+            }
+            info!("loaded {} events from the event store", n_events);
+            damus.store = Some(store);
+        }
+    }
+}
+
 fn update_damus(damus: &mut Damus, ctx: &egui::Context) {
     if damus.state == DamusState::Initializing {
         #[cfg(feature = "profiling")]
         setup_profiling();
 
         setup_gossip_fonts(ctx);
-        damus.pool = RelayPool::new();
-        relay_setup(&mut damus.pool, ctx);
+        // profiles first, so replayed and incoming notes render with
+        // names instead of a "nostrich" flash
+        #[cfg(not(target_arch = "wasm32"))]
+        damus.contacts.load_snapshot();
+        #[cfg(not(target_arch = "wasm32"))]
+        setup_event_store(damus);
+
+        let ctx = ctx.clone();
+        let wakeup = move || {
+            ctx.request_repaint();
+        };
+        let mut ingest = Ingest::new(wakeup);
+        relay_setup(&mut ingest);
+        damus.ingest = Some(ingest);
         damus.state = DamusState::Initialized;
     }
 
     try_process_event(damus, ctx);
+
+    #[cfg(not(target_arch = "wasm32"))]
+    crate::metrics::maybe_dump();
+    #[cfg(not(target_arch = "wasm32"))]
+    maybe_save_contacts(damus);
+}
+
+/// Snapshot contacts on a slow periodic tick, so a crash or kill loses
+/// at most a minute of profile updates. The eframe save hook covers
+/// clean shutdowns where the platform provides storage.
+#[cfg(not(target_arch = "wasm32"))]
+fn maybe_save_contacts(damus: &mut Damus) {
+    use std::sync::Mutex;
+    use std::time::Instant;
+
+    const SAVE_EVERY: Duration = Duration::from_secs(60);
+    static LAST_SAVE: Mutex<Option<Instant>> = Mutex::new(None);
+
+    let mut last = LAST_SAVE.lock().unwrap();
+    if let Some(at) = *last {
+        if at.elapsed() < SAVE_EVERY {
+            return;
+        }
+    }
+    *last = Some(Instant::now());
+    drop(last);
+
+    damus.contacts.save_snapshot();
 }
 
-fn process_metadata_event(damus: &mut Damus, ev: &Event) {
+/// Process a kind-0 profile event. Returns true if the profile was
+/// accepted, false if it was a duplicate or older than what we have.
+fn process_metadata_event(damus: &mut Damus, ev: &Event) -> bool {
     #[cfg(feature = "profiling")]
     puffin::profile_function!();
 
     if let Some(prev_id) = damus.contacts.events.get(&ev.pubkey) {
+        if prev_id == &ev.id {
+            return false;
+        }
         if let Some(prev_ev) = damus.all_events.get(prev_id) {
             // This profile event is older, ignore it
-            if prev_ev.created_at >= ev.created_at {
-                return;
+            if prev_ev.created_at() >= ev.created_at {
+                return false;
             }
         }
     }
 
-    let profile: core::result::Result<serde_json::Value, serde_json::Error> =
-        serde_json::from_str(&ev.content);
-
-    match profile {
+    match Profile::from_json(&ev.content) {
         Err(e) => {
             debug!("Invalid profile data '{}': {:?}", &ev.content, &e);
-        }
-        Ok(v) if !v.is_object() => {
-            debug!("Invalid profile data: '{}'", &ev.content);
+            false
         }
         Ok(profile) => {
+            damus.pending_authors.remove(&ev.pubkey);
+            damus.contacts.dirty = true;
+
             damus
                 .contacts
                 .events
@@ -187,47 +657,89 @@ fn process_metadata_event(damus: &mut Damus, ev: &Event) {
             damus
                 .contacts
                 .profiles
-                .insert(ev.pubkey.clone(), Profile::new(profile));
+                .insert(ev.pubkey.clone(), profile);
+
+            true
         }
     }
 }
 
-fn process_event(damus: &mut Damus, _subid: &str, event: Event) {
+fn process_event(damus: &mut Damus, _subid: &str, event: Event, note: Option<Note>) {
     #[cfg(feature = "profiling")]
     puffin::profile_function!();
 
-    if damus.all_events.get(&event.id).is_some() {
+    if damus.all_events.contains(&event.id) {
         return;
     }
 
     let kind = event.kind;
     if kind == 0 {
-        process_metadata_event(damus, &event);
+        if process_metadata_event(damus, &event) {
+            if let Some(store) = &mut damus.store {
+                store.append(&event);
+            }
+        }
     } else if kind == 1 {
-        let cloned_id = event.id.clone();
-        damus.all_events.insert(cloned_id.clone(), event);
-        damus.events.insert(0, cloned_id);
-    }
-}
+        if let Some(store) = &mut damus.store {
+            store.append(&event);
+        }
+        if !damus.contacts.profiles.contains_key(&event.pubkey) {
+            damus.pending_authors.insert(event.pubkey);
+        }
+        // ingest pre-shatters; replayed and test events do it here
+        let note = note.unwrap_or_else(|| Note::from_event(&event));
 
-fn get_unknown_author_ids(damus: &Damus) -> Vec<Pubkey> {
-    #[cfg(feature = "profiling")]
-    puffin::profile_function!();
+        for panel in &mut damus.panels {
+            if !panel
+                .filter
+                .matches(event.kind, &event.pubkey, &event.content, Some(&note))
+            {
+                continue;
+            }
+            if panel.timeline.insert(event.created_at, event.id) {
+                if let Some(anchor) = panel.view_state.anchor {
+                    let nref = NoteRef {
+                        created_at: event.created_at,
+                        id: event.id,
+                    };
+                    if nref > anchor {
+                        panel.view_state.inserted_above += 1;
+                    }
+                }
+            }
+        }
 
-    let mut authors: HashSet<Pubkey> = HashSet::new();
+        damus.oldest_note_at = Some(match damus.oldest_note_at {
+            Some(at) => at.min(event.created_at),
+            None => event.created_at,
+        });
 
-    for (_evid, ev) in damus.all_events.iter() {
-        if !damus.contacts.profiles.contains_key(&ev.pubkey) {
-            authors.insert(ev.pubkey.clone());
-        }
+        damus.notes.insert(event.id, note);
+        damus.all_events.insert(&event);
     }
+}
 
-    authors.into_iter().collect()
+/// Authors we still need profiles for and haven't asked any relay about
+/// yet. The pending set is maintained incrementally at ingest time, so
+/// this is a set difference over pending authors rather than a scan of
+/// every stored event.
+fn take_unrequested_authors(damus: &mut Damus) -> Vec<Pubkey> {
+    let authors: Vec<Pubkey> = damus
+        .pending_authors
+        .difference(&damus.requested_authors)
+        .copied()
+        .collect();
+
+    damus.requested_authors.extend(authors.iter().copied());
+    authors
 }
 
 fn handle_eose(damus: &mut Damus, subid: &str, relay_url: &str) {
     if subid == "initial" {
-        let authors = get_unknown_author_ids(damus);
+        let authors = take_unrequested_authors(damus);
+        if authors.is_empty() {
+            return;
+        }
         let n_authors = authors.len();
         let filter = Filter::new().authors(authors).kinds(vec![0]);
         info!(
@@ -235,17 +747,25 @@ fn handle_eose(damus: &mut Damus, subid: &str, relay_url: &str) {
             n_authors, relay_url
         );
         let msg = ClientMessage::req("profiles".to_string(), vec![filter]);
-        damus.pool.send_to(&msg, relay_url);
+        if let Some(ingest) = &mut damus.ingest {
+            // a one-shot query; any relay's answer is enough, so don't
+            // tie it to whichever relay happened to EOSE first
+            ingest.send_fastest(msg);
+        }
     } else if subid == "profiles" {
         info!("Got profiles from {}", relay_url);
         let msg = ClientMessage::close("profiles".to_string());
-        damus.pool.send_to(&msg, relay_url);
+        if let Some(ingest) = &mut damus.ingest {
+            ingest.send_to(msg, relay_url.to_string());
+        }
+    } else if subid == "backfill" {
+        handle_backfill_eose(damus);
     }
 }
 
-fn process_message(damus: &mut Damus, relay: &str, msg: RelayMessage) {
+fn process_message(damus: &mut Damus, relay: &str, msg: RelayMessage, note: Option<Note>) {
     match msg {
-        RelayMessage::Event(subid, ev) => process_event(damus, &subid, ev),
+        RelayMessage::Event(subid, ev) => process_event(damus, &subid, ev, note),
         RelayMessage::Notice(msg) => warn!("Notice from {}: {}", relay, msg),
         RelayMessage::OK(cr) => info!("OK {:?}", cr),
         RelayMessage::Eose(sid) => handle_eose(damus, &sid, relay),
@@ -259,6 +779,12 @@ fn render_damus(damus: &mut Damus, ctx: &Context) {
         render_damus_desktop(ctx, damus);
     }
 
+    // No periodic repaint on native: every state change already requests
+    // one — the ingest wakeup when a batch lands, image loads when a
+    // texture is ready, leftover-budget processing, and egui itself for
+    // input. An idle app paints nothing. Wasm drives the relay pool and
+    // its keepalive pings inline from update, so it keeps a slow tick.
+    #[cfg(target_arch = "wasm32")]
     ctx.request_repaint_after(Duration::from_secs(1));
 
     #[cfg(feature = "profiling")]
@@ -321,23 +847,22 @@ fn render_pfp(ui: &mut egui::Ui, img_cache: &mut ImageCache, url: &str) {
                     ui.label("❌");
                 }
                 Some(Ok(img)) => {
-                    pfp_image(ui, img.into(), pfp_size);
+                    pfp_image(ui, img, pfp_size);
                 }
             }
         }
         Some(Ok(img)) => {
-            pfp_image(ui, img.into(), pfp_size);
+            pfp_image(ui, img, pfp_size);
         }
     }
 }
 
-fn pfp_image(ui: &mut egui::Ui, img: TextureId, size: f32) -> egui::Response {
+fn pfp_image(ui: &mut egui::Ui, img: &AtlasHandle, size: f32) -> egui::Response {
     #[cfg(feature = "profiling")]
     puffin::profile_function!();
 
-    //img.show_max_size(ui, egui::vec2(size, size))
-    ui.image(img, egui::vec2(size, size))
-    //.with_options()
+    // a uv sub-rect of a shared atlas page, not a texture of its own
+    ui.add(egui::Image::new(img.tex(), egui::vec2(size, size)).uv(img.uv()))
 }
 
 fn ui_abbreviate_name(ui: &mut egui::Ui, name: &str, len: usize) {
@@ -376,55 +901,100 @@ fn no_pfp_url() -> &'static str {
     "https://damus.io/img/no-profile.svg"
 }
 
+/// Lay out only the notes that intersect the viewport. Heights come from
+/// the measurement cache, falling back to a running average for notes we
+/// haven't laid out yet; measured heights feed back into the cache so
+/// the scrollbar converges as the user scrolls.
 fn render_notes_in_viewport(
     ui: &mut egui::Ui,
     damus: &mut Damus,
+    panel_ix: usize,
     viewport: egui::Rect,
-    row_height: f32,
-    font_id: egui::FontId,
 ) {
-    let num_rows = 10_000;
-    ui.set_height(row_height * num_rows as f32);
-
-    let first_item = (viewport.min.y / row_height).floor().max(0.0) as usize;
-    let last_item = (viewport.max.y / row_height).ceil() as usize + 1;
-    let last_item = last_item.min(num_rows);
-
-    let mut used_rect = egui::Rect::NOTHING;
-
-    for i in first_item..last_item {
-        let padding = (i % 100) as f32;
-        let indent = (((i as f32) / 10.0).sin() * 20.0) + 10.0;
-        let x = ui.min_rect().left() + indent;
-        let y = ui.min_rect().top() + i as f32 * row_height;
-        let text = format!(
-            "This is row {}/{}, indented by {} pixels",
-            i + 1,
-            num_rows,
-            indent
-        );
-        let text_rect = ui.painter().text(
-            egui::pos2(x, y),
-            egui::Align2::LEFT_TOP,
-            text,
-            font_id.clone(),
-            ui.visuals().text_color(),
+    #[cfg(feature = "profiling")]
+    puffin::profile_function!();
+
+    #[cfg(not(target_arch = "wasm32"))]
+    let started_at = std::time::Instant::now();
+
+    damus.panels[panel_ix]
+        .view_state
+        .check_width(ui.available_width());
+
+    // pass 1: walk the index to find the visible range and total height
+    let mut y = 0.0;
+    let mut visible: Vec<(NoteRef, f32)> = vec![];
+    {
+        let panel = &damus.panels[panel_ix];
+        for nref in panel.timeline.notes() {
+            let height = panel.view_state.height_of(&nref.id);
+            if y + height >= viewport.min.y && y <= viewport.max.y {
+                visible.push((*nref, y));
+            }
+            y += height;
+        }
+    }
+    ui.set_height(y);
+
+    if let Some((first, _offset)) = visible.first() {
+        damus.panels[panel_ix].view_state.anchor = Some(*first);
+    }
+
+    // pass 2: lay out the visible notes at their offsets
+    let left = ui.min_rect().left();
+    let top = ui.min_rect().top();
+    let width = ui.available_width();
+    let mut mismeasured = false;
+
+    for (nref, offset) in visible {
+        if !damus.all_events.contains(&nref.id) {
+            continue;
+        }
+
+        let used = damus.panels[panel_ix].view_state.height_of(&nref.id);
+        let rect = egui::Rect::from_min_size(
+            egui::pos2(left, top + offset),
+            egui::vec2(width, used),
         );
-        used_rect = used_rect.union(text_rect);
+
+        let response = ui.allocate_ui_at_rect(rect, |ui| {
+            ui.set_width(width);
+            render_note(ui, damus, panel_ix, nref.id);
+            ui.separator();
+        });
+
+        let measured = response.response.rect.height();
+        if (measured - used).abs() > 0.5 {
+            mismeasured = true;
+        }
+        damus.panels[panel_ix]
+            .view_state
+            .record_height(nref.id, measured);
     }
 
-    ui.allocate_rect(used_rect, egui::Sense::hover()); // make sure it is visible!
+    // offsets were computed from stale heights; redo the layout with the
+    // fresh measurements
+    if mismeasured {
+        ui.ctx().request_repaint();
+    }
+
+    #[cfg(not(target_arch = "wasm32"))]
+    damus
+        .frame_history
+        .record_render_notes(started_at.elapsed().as_secs_f32());
 }
 
-fn render_note(ui: &mut egui::Ui, damus: &mut Damus, index: usize) {
+fn render_note(ui: &mut egui::Ui, damus: &mut Damus, panel_ix: usize, id: EventId) {
     ui.with_layout(egui::Layout::left_to_right(egui::Align::TOP), |ui| {
-        let ev = damus.all_events.get(&damus.events[index]).unwrap();
+        let ev = damus.all_events.get(&id).unwrap();
+        let pubkey = *ev.pubkey();
+        let content = ev.content();
 
         padding(10.0, ui, |ui| {
             match damus
                 .contacts
                 .profiles
-                .get(&ev.pubkey)
+                .get(&pubkey)
                 .and_then(|p| p.picture())
             {
                 // these have different lifetimes and types,
@@ -434,48 +1004,111 @@ fn render_note(ui: &mut egui::Ui, damus: &mut Damus, index: usize) {
             }
 
             ui.with_layout(egui::Layout::top_down(egui::Align::LEFT), |ui| {
-                render_username(ui, &damus.contacts, &ev.pubkey);
-
-                ui.label(&ev.content);
+                render_username(ui, &damus.contacts, &pubkey);
+
+                let galley = damus.panels[panel_ix].view_state.note_galley(
+                    ui,
+                    id,
+                    content,
+                    damus.notes.get(&id),
+                );
+                let (rect, _) = ui.allocate_exact_size(galley.size(), egui::Sense::hover());
+                ui.painter().galley(rect.min, galley);
             })
         })
     });
 }
 
-fn render_notes(ui: &mut egui::Ui, damus: &mut Damus) {
-    #[cfg(feature = "profiling")]
-    puffin::profile_function!();
+fn timeline_view(ui: &mut egui::Ui, app: &mut Damus, panel_ix: usize) {
+    padding(10.0, ui, |ui| {
+        ui.horizontal(|ui| {
+            ui.heading("Timeline");
+            let response = ui.add(
+                egui::TextEdit::singleline(&mut app.panels[panel_ix].filter_input)
+                    .hint_text("#hashtag")
+                    .desired_width(120.0),
+            );
+            if response.lost_focus() && ui.input(|i| i.key_pressed(egui::Key::Enter)) {
+                set_panel_hashtag(app, panel_ix);
+            }
+        })
+    });
 
-    for i in 0..damus.events.len().min(50) {
-        if !damus.all_events.contains_key(&damus.events[i]) {
-            continue;
-        }
+    let mut scroll_area = egui::ScrollArea::vertical()
+        .scroll_bar_visibility(ScrollBarVisibility::AlwaysHidden)
+        .auto_shrink([false; 2])
+        .id_source(("timeline", panel_ix));
+
+    if let Some(target) = app.panels[panel_ix].view_state.scroll_to.take() {
+        scroll_area = scroll_area.vertical_scroll_offset(target);
+    }
 
-        render_note(ui, damus, i);
+    let output = scroll_area.show_viewport(ui, |ui, viewport| {
+        render_notes_in_viewport(ui, app, panel_ix, viewport);
+    });
+
+    // Nearing the bottom of any panel pulls the next history window.
+    // Also fires while the content is shorter than the viewport, so a
+    // fresh session keeps paging until the screen is full.
+    let near_bottom = output.state.offset.y + output.inner_rect.height()
+        >= output.content_size.y - 2.0 * DEFAULT_NOTE_HEIGHT;
+    if near_bottom {
+        maybe_request_backfill(app);
+    }
 
-        ui.separator();
+    // Notes that arrived above the anchor this frame shift everything
+    // below them down. If the user isn't at the top, bump the scroll
+    // offset by the estimated inserted height so the viewport stays
+    // visually still.
+    let offset = output.state.offset.y;
+    let view_state = &mut app.panels[panel_ix].view_state;
+    if view_state.inserted_above > 0 && offset > 0.0 {
+        let shift = view_state.inserted_above as f32 * view_state.estimated_height();
+        view_state.scroll_to = Some(offset + shift);
     }
+    view_state.inserted_above = 0;
 }
 
-fn timeline_view(ui: &mut egui::Ui, app: &mut Damus) {
-    padding(10.0, ui, |ui| ui.heading("Timeline"));
+/// Parse the panel's filter box into its hashtag filter and rebuild the
+/// panel index from events we already have. Future events keep matching
+/// incrementally at ingest.
+fn set_panel_hashtag(app: &mut Damus, panel_ix: usize) {
+    let hashtag = app.panels[panel_ix]
+        .filter_input
+        .trim()
+        .trim_start_matches('#')
+        .to_lowercase();
+
+    app.panels[panel_ix].filter.hashtag = if hashtag.is_empty() {
+        None
+    } else {
+        Some(hashtag)
+    };
 
-    /*
-    let font_id = egui::TextStyle::Body.resolve(ui.style());
-    let row_height = ui.fonts(|f| f.row_height(&font_id)) + ui.spacing().item_spacing.y;
-    */
+    rebuild_panel(app, panel_ix);
+}
 
-    egui::ScrollArea::vertical()
-        .scroll_bar_visibility(ScrollBarVisibility::AlwaysHidden)
-        .auto_shrink([false; 2])
-        /*
-        .show_viewport(ui, |ui, viewport| {
-            render_notes_in_viewport(ui, app, viewport, row_height, font_id);
-        });
-        */
-        .show(ui, |ui| {
-            render_notes(ui, app);
-        });
+/// Re-materialize one panel's timeline against its filter. Only runs
+/// when the filter itself changes; steady-state matching is incremental.
+fn rebuild_panel(app: &mut Damus, panel_ix: usize) {
+    let panel = &mut app.panels[panel_ix];
+    panel.timeline = Timeline::new();
+    panel.view_state.anchor = None;
+    panel.view_state.inserted_above = 0;
+    panel.view_state.scroll_to = None;
+
+    for ev in app.all_events.iter() {
+        if ev.kind() != 1 {
+            continue;
+        }
+        let id = ev.id();
+        if panel
+            .filter
+            .matches(ev.kind(), ev.pubkey(), ev.content(), app.notes.get(&id))
+        {
+            panel.timeline.insert(ev.created_at(), id);
+        }
+    }
 }
 
 fn top_panel(ctx: &egui::Context) -> egui::TopBottomPanel {
@@ -514,27 +1147,63 @@ fn render_panel(ctx: &egui::Context, app: &mut Damus) {
                 .on_hover_text("Add Timeline")
                 .clicked()
             {
-                app.n_panels += 1;
+                app.panels.push(Panel::new());
             }
 
-            if app.n_panels != 1
+            if app.panels.len() != 1
                 && ui
                     .add(egui::Button::new("-").frame(false))
                     .on_hover_text("Remove Timeline")
                     .clicked()
             {
-                app.n_panels -= 1;
+                app.panels.pop();
             }
 
-            ui.label(format!(
+            let fps_label = egui::Label::new(format!(
                 "FPS: {:.2}, {:10.1}ms",
                 app.frame_history.fps(),
                 app.frame_history.mean_frame_time() * 1e3
-            ));
+            ))
+            .sense(egui::Sense::click());
+            if ui
+                .add(fps_label)
+                .on_hover_text("Click to toggle the jank breakdown")
+                .clicked()
+            {
+                app.frame_history.show_overlay = !app.frame_history.show_overlay;
+            }
+
+            ui.label(format!("{} notes", app.notes.len()));
 
-            ui.label(format!("{} notes", app.events.len()));
+            let msgs = enostr::metrics::RELAY_MESSAGES.get();
+            let dups = enostr::metrics::DUP_FRAMES_DROPPED.get();
+            ui.label(format!(
+                "msgs: {} ({:.0}% dup), parse p99: {}µs",
+                msgs,
+                if msgs > 0 {
+                    dups as f64 / (msgs as f64) * 100.0
+                } else {
+                    0.0
+                },
+                enostr::metrics::PARSE_NS.approx_quantile(0.99) / 1000,
+            ))
+            .on_hover_text(crate::metrics::dump_json());
+
+            let queued = crate::metrics::queue_depth();
+            if queued > 0 {
+                ui.label(format!("queued: {}", queued));
+            }
         });
     });
+
+    if app.frame_history.show_overlay {
+        egui::Window::new("jank")
+            .default_width(340.0)
+            .show(ctx, |ui| {
+                set_app_style(ui);
+                app.frame_history.jank_ui(ui);
+            });
+    }
 }
 
 fn set_app_style(ui: &mut egui::Ui) {
@@ -557,7 +1226,7 @@ fn render_damus_mobile(ctx: &egui::Context, app: &mut Damus) {
     egui::CentralPanel::default().show(ctx, |ui| {
         set_app_style(ui);
         timeline_panel(ui, panel_width, 0, |ui| {
-            timeline_view(ui, app);
+            timeline_view(ui, app, 0);
         });
     });
 }
@@ -568,7 +1237,7 @@ fn render_damus_desktop(ctx: &egui::Context, app: &mut Damus) {
     puffin::profile_function!();
 
     let screen_size = ctx.screen_rect().width();
-    let calc_panel_width = (screen_size / app.n_panels as f32) - 30.0;
+    let calc_panel_width = (screen_size / app.panels.len() as f32) - 30.0;
     let min_width = 300.0;
     let need_scroll = calc_panel_width < min_width;
     let panel_width = if need_scroll {
@@ -577,13 +1246,13 @@ fn render_damus_desktop(ctx: &egui::Context, app: &mut Damus) {
         calc_panel_width
     };
 
-    if app.n_panels == 1 {
+    if app.panels.len() == 1 {
         let panel_width = ctx.screen_rect().width();
         egui::CentralPanel::default().show(ctx, |ui| {
             set_app_style(ui);
             timeline_panel(ui, panel_width, 0, |ui| {
                 //postbox(ui, app);
-                timeline_view(ui, app);
+                timeline_view(ui, app, 0);
             });
         });
 
@@ -595,12 +1264,12 @@ fn render_damus_desktop(ctx: &egui::Context, app: &mut Damus) {
         egui::ScrollArea::horizontal()
             .auto_shrink([false; 2])
             .show(ui, |ui| {
-                for ind in 0..app.n_panels {
+                for ind in 0..app.panels.len() {
                     if ind == 0 {
                         //postbox(ui, app);
                     }
-                    timeline_panel(ui, panel_width, ind, |ui| {
-                        timeline_view(ui, app);
+                    timeline_panel(ui, panel_width, ind as u32, |ui| {
+                        timeline_view(ui, app, ind);
                     });
                 }
             });
@@ -647,49 +1316,45 @@ fn add_test_events(damus: &mut Damus) {
     // For inspiration and more examples, go to https://emilk.github.io/egui
 
     let test_event = Event {
-        id: "6938e3cd841f3111dbdbd909f87fd52c3d1f1e4a07fd121d1243196e532811cb".to_string().into(),
-        pubkey: "f0a6ff7f70b872de6d82c8daec692a433fd23b6a49f25923c6f034df715cdeec".to_string().into(),
+        id: EventId::from_hex("6938e3cd841f3111dbdbd909f87fd52c3d1f1e4a07fd121d1243196e532811cb").expect("id"),
+        pubkey: Pubkey::from_hex("f0a6ff7f70b872de6d82c8daec692a433fd23b6a49f25923c6f034df715cdeec").expect("pk"),
         created_at: 1667781968,
         kind: 1,
         tags: vec![],
         content: LOREM_IPSUM.into(),
-        sig: "af02c971015995f79e07fa98aaf98adeeb6a56d0005e451ee4e78844cff712a6bc0f2109f72a878975f162dcefde4173b65ebd4c3d3ab3b520a9dcac6acf092d".to_string(),
+        sig: Sig::from_hex("af02c971015995f79e07fa98aaf98adeeb6a56d0005e451ee4e78844cff712a6bc0f2109f72a878975f162dcefde4173b65ebd4c3d3ab3b520a9dcac6acf092d").expect("sig"),
     };
 
     let test_event2 = Event {
-        id: "6938e3cd841f3111dbdbd909f87fd52c3d1f1e4a07fd121d1243196e532811cb".to_string().into(),
-        pubkey: "32e1827635450ebb3c5a7d12c1f8e7b2b514439ac10a67eef3d9fd9c5c68e245".to_string().into(),
+        id: EventId::from_hex("6938e3cd841f3111dbdbd909f87fd52c3d1f1e4a07fd121d1243196e532811cb").expect("id"),
+        pubkey: Pubkey::from_hex("32e1827635450ebb3c5a7d12c1f8e7b2b514439ac10a67eef3d9fd9c5c68e245").expect("pk"),
         created_at: 1667781968,
         kind: 1,
         tags: vec![],
         content: LOREM_IPSUM_LONG.into(),
-        sig: "af02c971015995f79e07fa98aaf98adeeb6a56d0005e451ee4e78844cff712a6bc0f2109f72a878975f162dcefde4173b65ebd4c3d3ab3b520a9dcac6acf092d".to_string(),
+        sig: Sig::from_hex("af02c971015995f79e07fa98aaf98adeeb6a56d0005e451ee4e78844cff712a6bc0f2109f72a878975f162dcefde4173b65ebd4c3d3ab3b520a9dcac6acf092d").expect("sig"),
     };
 
     damus
-        .all_events
-        .insert(test_event.id.clone(), test_event.clone());
+        .notes
+        .insert(test_event.id, Note::from_event(&test_event));
     damus
-        .all_events
-        .insert(test_event2.id.clone(), test_event2.clone());
+        .notes
+        .insert(test_event2.id, Note::from_event(&test_event2));
+
+    damus.all_events.insert(&test_event);
+    damus.all_events.insert(&test_event2);
 
-    if damus.events.is_empty() {
-        damus.events.push(test_event.id.clone());
-        damus.events.push(test_event2.id.clone());
-        damus.events.push(test_event.id.clone());
-        damus.events.push(test_event2.id.clone());
-        damus.events.push(test_event.id.clone());
-        damus.events.push(test_event2.id.clone());
-        damus.events.push(test_event.id.clone());
-        damus.events.push(test_event2.id);
-        damus.events.push(test_event.id);
+    for ix in 0..damus.panels.len() {
+        rebuild_panel(damus, ix);
     }
 }
 
 impl eframe::App for Damus {
     /// Called by the frame work to save state before shutdown.
     fn save(&mut self, _storage: &mut dyn eframe::Storage) {
-        //eframe::set_value(storage, eframe::APP_KEY, self);
+        #[cfg(not(target_arch = "wasm32"))]
+        self.contacts.save_snapshot();
     }
 
     /// Called each time the UI needs repainting, which may be many times per second.
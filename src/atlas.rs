@@ -0,0 +1,152 @@
+use egui::{Color32, ColorImage, Context, Rect, TextureHandle, TextureId, TextureOptions};
+use std::sync::{Mutex, OnceLock};
+
+/// Side of one avatar slot, matching the avatar size images.rs decodes
+/// to. Anything that fits gets packed; anything bigger falls back to its
+/// own texture.
+pub const SLOT: usize = 100;
+
+/// Side of one atlas page in texels.
+const PAGE: usize = 1024;
+
+/// Slot pitch: one transparent texel each side so bilinear sampling at a
+/// region's edge never bleeds a neighboring avatar in.
+const STRIDE: usize = SLOT + 2;
+
+/// Slots per page axis; 100 avatars per page.
+const PER_AXIS: usize = PAGE / STRIDE;
+
+struct Page {
+    tex: TextureHandle,
+    /// next never-claimed slot
+    next: usize,
+    /// slots handed back by dropped handles, reused before `next` grows
+    free: Vec<usize>,
+}
+
+struct Atlas {
+    pages: Vec<Page>,
+}
+
+static ATLAS: OnceLock<Mutex<Atlas>> = OnceLock::new();
+
+fn atlas() -> &'static Mutex<Atlas> {
+    ATLAS.get_or_init(|| Mutex::new(Atlas { pages: vec![] }))
+}
+
+/// A claimed region of an atlas page. Dropping the handle returns the
+/// slot for reuse, mirroring how TextureHandle frees its texture.
+pub struct AtlasHandle {
+    tex: TextureId,
+    uv: Rect,
+    kind: Kind,
+}
+
+enum Kind {
+    Slot { page: usize, slot: usize },
+    /// oversized images keep a dedicated texture; the handle keeps it
+    /// alive
+    Own(#[allow(dead_code)] TextureHandle),
+}
+
+impl AtlasHandle {
+    pub fn tex(&self) -> TextureId {
+        self.tex
+    }
+
+    /// The uv sub-rect of this image within its page.
+    pub fn uv(&self) -> Rect {
+        self.uv
+    }
+}
+
+impl Drop for AtlasHandle {
+    fn drop(&mut self) {
+        if let Kind::Slot { page, slot } = self.kind {
+            let mut atlas = atlas().lock().unwrap();
+            if let Some(page) = atlas.pages.get_mut(page) {
+                page.free.push(slot);
+            }
+        }
+    }
+}
+
+/// Upload an image into the avatar atlas and claim its region. Safe to
+/// call from the image workers: egui's texture manager is internally
+/// locked and queues the upload for the next frame. Many avatars end up
+/// sharing one GPU texture, so a scroll through an author-diverse
+/// timeline binds a page or two instead of a texture per note.
+pub fn insert(ctx: &Context, name: &str, img: ColorImage) -> AtlasHandle {
+    let [w, h] = img.size;
+    if w == 0 || h == 0 || w > SLOT || h > SLOT {
+        let tex = ctx.load_texture(name, img, Default::default());
+        return AtlasHandle {
+            tex: tex.id(),
+            uv: Rect::from_min_max(egui::pos2(0.0, 0.0), egui::pos2(1.0, 1.0)),
+            kind: Kind::Own(tex),
+        };
+    }
+
+    let mut atlas = atlas().lock().unwrap();
+
+    let page_ix = match atlas
+        .pages
+        .iter()
+        .position(|p| !p.free.is_empty() || p.next < PER_AXIS * PER_AXIS)
+    {
+        Some(ix) => ix,
+        None => {
+            let tex = ctx.load_texture(
+                format!("pfp-atlas-{}", atlas.pages.len()),
+                ColorImage::new([PAGE, PAGE], Color32::TRANSPARENT),
+                TextureOptions::default(),
+            );
+            atlas.pages.push(Page {
+                tex,
+                next: 0,
+                free: vec![],
+            });
+            atlas.pages.len() - 1
+        }
+    };
+
+    let page = &mut atlas.pages[page_ix];
+    let (slot, reused) = match page.free.pop() {
+        Some(slot) => (slot, true),
+        None => {
+            let slot = page.next;
+            page.next += 1;
+            (slot, false)
+        }
+    };
+
+    // +1 lands inside the slot's gutter, keeping a transparent texel
+    // ring around every region
+    let x = (slot % PER_AXIS) * STRIDE + 1;
+    let y = (slot / PER_AXIS) * STRIDE + 1;
+
+    if reused {
+        // clear out whatever the previous occupant left behind
+        page.tex.set_partial(
+            [x, y],
+            ColorImage::new([SLOT, SLOT], Color32::TRANSPARENT),
+            TextureOptions::default(),
+        );
+    }
+    page.tex
+        .set_partial([x, y], img, TextureOptions::default());
+
+    let uv = Rect::from_min_max(
+        egui::pos2(x as f32 / PAGE as f32, y as f32 / PAGE as f32),
+        egui::pos2((x + w) as f32 / PAGE as f32, (y + h) as f32 / PAGE as f32),
+    );
+
+    AtlasHandle {
+        tex: page.tex.id(),
+        uv,
+        kind: Kind::Slot {
+            page: page_ix,
+            slot,
+        },
+    }
+}
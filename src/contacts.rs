@@ -4,6 +4,9 @@ use std::collections::HashMap;
 pub struct Contacts {
     pub events: HashMap<Pubkey, EventId>,
     pub profiles: HashMap<Pubkey, Profile>,
+    /// set when a profile is accepted, cleared on snapshot; unchanged
+    /// contacts never rewrite the snapshot
+    pub dirty: bool,
 }
 
 impl Contacts {
@@ -11,6 +14,255 @@ impl Contacts {
         Contacts {
             events: HashMap::new(),
             profiles: HashMap::new(),
+            dirty: false,
+        }
+    }
+}
+
+/// Binary contact snapshotting. One compact length-prefixed file holds
+/// the pubkey → profile map plus the profile event id per entry, so a
+/// fresh launch renders usernames and avatar urls immediately and the
+/// profiles REQ only asks for genuinely unknown authors. The event log
+/// stays the source of truth for notes; this is just the profile cache
+/// skipping a json replay.
+#[cfg(not(target_arch = "wasm32"))]
+mod snapshot {
+    use super::Contacts;
+    use enostr::{EventId, Profile, Pubkey};
+    use std::collections::HashMap;
+    use std::path::PathBuf;
+    use tracing::{debug, warn};
+
+    const MAGIC: &[u8; 4] = b"NDCT";
+    const VERSION: u8 = 1;
+
+    /// Length prefix for an absent string.
+    const NONE_LEN: u32 = u32::MAX;
+
+    fn snapshot_path() -> Option<PathBuf> {
+        crate::storage::data_dir().map(|d| d.join("contacts.bin"))
+    }
+
+    fn write_opt_str(buf: &mut Vec<u8>, s: &Option<String>) {
+        match s {
+            None => buf.extend_from_slice(&NONE_LEN.to_le_bytes()),
+            Some(s) => {
+                buf.extend_from_slice(&(s.len() as u32).to_le_bytes());
+                buf.extend_from_slice(s.as_bytes());
+            }
+        }
+    }
+
+    fn read_exact<'a>(bytes: &'a [u8], pos: &mut usize, n: usize) -> Option<&'a [u8]> {
+        let out = bytes.get(*pos..*pos + n)?;
+        *pos += n;
+        Some(out)
+    }
+
+    fn read_opt_str(bytes: &[u8], pos: &mut usize) -> Option<Option<String>> {
+        let len = u32::from_le_bytes(read_exact(bytes, pos, 4)?.try_into().unwrap());
+        if len == NONE_LEN {
+            return Some(None);
+        }
+        let s = read_exact(bytes, pos, len as usize)?;
+        Some(Some(String::from_utf8(s.to_vec()).ok()?))
+    }
+
+    impl Contacts {
+        /// Write the snapshot if anything changed since the last one.
+        /// Goes through a temp file and rename so a crash mid-write
+        /// can't leave a torn snapshot behind.
+        pub fn save_snapshot(&mut self) {
+            if !self.dirty {
+                return;
+            }
+
+            let path = match snapshot_path() {
+                Some(path) => path,
+                None => return,
+            };
+            if let Some(parent) = path.parent() {
+                if std::fs::create_dir_all(parent).is_err() {
+                    return;
+                }
+            }
+
+            let mut buf = Vec::with_capacity(64 + self.profiles.len() * 256);
+            buf.extend_from_slice(MAGIC);
+            buf.push(VERSION);
+            buf.extend_from_slice(&(self.profiles.len() as u32).to_le_bytes());
+
+            for (pk, profile) in &self.profiles {
+                buf.extend_from_slice(pk.bytes());
+                let evid = self
+                    .events
+                    .get(pk)
+                    .map(|id| *id.bytes())
+                    .unwrap_or([0u8; 32]);
+                buf.extend_from_slice(&evid);
+
+                for s in [
+                    &profile.name,
+                    &profile.display_name,
+                    &profile.picture,
+                    &profile.banner,
+                    &profile.about,
+                    &profile.website,
+                    &profile.lud06,
+                    &profile.lud16,
+                    &profile.nip05,
+                ] {
+                    write_opt_str(&mut buf, s);
+                }
+            }
+
+            let tmp = path.with_extension("bin.tmp");
+            let written = std::fs::write(&tmp, &buf).and_then(|_| std::fs::rename(&tmp, &path));
+            match written {
+                Ok(()) => {
+                    debug!("contacts: snapshotted {} profiles", self.profiles.len());
+                    self.dirty = false;
+                }
+                Err(e) => warn!("contacts: snapshot write failed: {:?}", e),
+            }
+        }
+
+        /// Load the snapshot from a previous session, if there is one.
+        /// Corrupt or unknown-version snapshots are ignored; profiles
+        /// re-arrive over the wire like a first run.
+        pub fn load_snapshot(&mut self) {
+            let path = match snapshot_path() {
+                Some(path) => path,
+                None => return,
+            };
+            let bytes = match std::fs::read(&path) {
+                Ok(bytes) => bytes,
+                Err(_) => return, // first run
+            };
+
+            match self.parse_snapshot(&bytes) {
+                Some(n) => debug!("contacts: loaded {} profiles from {:?}", n, &path),
+                None => warn!("contacts: ignoring corrupt snapshot {:?}", &path),
+            }
+        }
+
+        fn parse_snapshot(&mut self, bytes: &[u8]) -> Option<usize> {
+            let mut pos = 0;
+
+            if read_exact(bytes, &mut pos, 4)? != MAGIC {
+                return None;
+            }
+            if *read_exact(bytes, &mut pos, 1)?.first()? != VERSION {
+                return None;
+            }
+            let count = u32::from_le_bytes(read_exact(bytes, &mut pos, 4)?.try_into().unwrap());
+
+            // parse into locals first, so a snapshot that turns out to
+            // be truncated mid-entry can't leave a half-loaded map
+            let mut events = HashMap::new();
+            let mut profiles = HashMap::new();
+
+            for _ in 0..count {
+                let pk = Pubkey::new(read_exact(bytes, &mut pos, 32)?.try_into().unwrap());
+                let evid: [u8; 32] = read_exact(bytes, &mut pos, 32)?.try_into().unwrap();
+
+                let profile = Profile {
+                    name: read_opt_str(bytes, &mut pos)?,
+                    display_name: read_opt_str(bytes, &mut pos)?,
+                    picture: read_opt_str(bytes, &mut pos)?,
+                    banner: read_opt_str(bytes, &mut pos)?,
+                    about: read_opt_str(bytes, &mut pos)?,
+                    website: read_opt_str(bytes, &mut pos)?,
+                    lud06: read_opt_str(bytes, &mut pos)?,
+                    lud16: read_opt_str(bytes, &mut pos)?,
+                    nip05: read_opt_str(bytes, &mut pos)?,
+                };
+
+                if evid != [0u8; 32] {
+                    events.insert(pk, EventId::new(evid));
+                }
+                profiles.insert(pk, profile);
+            }
+
+            self.events.extend(events);
+            self.profiles.extend(profiles);
+
+            Some(count as usize)
+        }
+    }
+
+    #[cfg(test)]
+    mod tests {
+        use super::*;
+
+        #[test]
+        fn test_snapshot_roundtrip() {
+            let mut contacts = Contacts::new();
+            let pk = Pubkey::new([7; 32]);
+            contacts.events.insert(pk, EventId::new([9; 32]));
+            contacts.profiles.insert(
+                pk,
+                Profile {
+                    name: Some("jb55".to_string()),
+                    picture: Some("https://damus.io/img/jb55.png".to_string()),
+                    ..Default::default()
+                },
+            );
+            contacts.dirty = true;
+
+            // serialize and parse back without touching the filesystem
+            let mut buf = Vec::new();
+            buf.extend_from_slice(MAGIC);
+            buf.push(VERSION);
+            buf.extend_from_slice(&1u32.to_le_bytes());
+            buf.extend_from_slice(pk.bytes());
+            buf.extend_from_slice(EventId::new([9; 32]).bytes());
+            let profile = contacts.profiles.get(&pk).unwrap().clone();
+            for s in [
+                &profile.name,
+                &profile.display_name,
+                &profile.picture,
+                &profile.banner,
+                &profile.about,
+                &profile.website,
+                &profile.lud06,
+                &profile.lud16,
+                &profile.nip05,
+            ] {
+                write_opt_str(&mut buf, s);
+            }
+
+            let mut loaded = Contacts::new();
+            assert_eq!(loaded.parse_snapshot(&buf), Some(1));
+            let got = loaded.profiles.get(&pk).expect("profile");
+            assert_eq!(got.name(), Some("jb55"));
+            assert_eq!(got.display_name(), None);
+            assert_eq!(loaded.events.get(&pk), Some(&EventId::new([9; 32])));
+        }
+
+        #[test]
+        fn test_truncated_snapshot_rejected() {
+            let mut contacts = Contacts::new();
+            assert_eq!(contacts.parse_snapshot(b"NDCT"), None);
+            assert!(contacts.profiles.is_empty());
+
+            // truncated mid-entry: header claims two profiles but the
+            // bytes run out after the second pubkey; nothing from the
+            // complete first entry may leak into the maps
+            let mut buf = Vec::new();
+            buf.extend_from_slice(MAGIC);
+            buf.push(VERSION);
+            buf.extend_from_slice(&2u32.to_le_bytes());
+            buf.extend_from_slice(Pubkey::new([7; 32]).bytes());
+            buf.extend_from_slice(&[0u8; 32]);
+            for _ in 0..9 {
+                buf.extend_from_slice(&super::NONE_LEN.to_le_bytes());
+            }
+            buf.extend_from_slice(Pubkey::new([8; 32]).bytes());
+
+            assert_eq!(contacts.parse_snapshot(&buf), None);
+            assert!(contacts.profiles.is_empty());
+            assert!(contacts.events.is_empty());
         }
     }
 }
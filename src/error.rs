@@ -1,10 +1,8 @@
-use shatter::parser;
-
 #[derive(Debug)]
 pub enum Error {
     Nostr(enostr::Error),
-    Shatter(parser::Error),
     Image(image::error::ImageError),
+    Io(std::io::Error),
     Generic(String),
 }
 
@@ -14,18 +12,18 @@ impl From<String> for Error {
     }
 }
 
-impl From<parser::Error> for Error {
-    fn from(s: parser::Error) -> Self {
-        Error::Shatter(s)
-    }
-}
-
 impl From<image::error::ImageError> for Error {
     fn from(err: image::error::ImageError) -> Self {
         Error::Image(err)
     }
 }
 
+impl From<std::io::Error> for Error {
+    fn from(err: std::io::Error) -> Self {
+        Error::Io(err)
+    }
+}
+
 impl From<enostr::Error> for Error {
     fn from(err: enostr::Error) -> Self {
         Error::Nostr(err)
@@ -0,0 +1,270 @@
+use enostr::{Event, EventId, Pubkey, Sig};
+use std::collections::hash_map::DefaultHasher;
+use std::collections::HashMap;
+use std::hash::{Hash, Hasher};
+
+/// A byte range into the arena buffer. Offsets instead of pointers, so
+/// the buffer is free to reallocate as it grows.
+#[derive(Debug, Clone, Copy)]
+struct Span {
+    start: u32,
+    end: u32,
+}
+
+/// The arena-resident form of an event: fixed-size fields inline, all
+/// strings as ranges into the shared buffer.
+struct Stored {
+    pubkey: Pubkey,
+    created_at: u64,
+    kind: u64,
+    #[allow(dead_code)]
+    sig: Sig,
+    content: Span,
+    /// range into `EventArena::tags`
+    tags: Span,
+}
+
+/// Bump-arena event storage. All strings for one event — content, then
+/// every tag element — are written into one growing buffer at insert
+/// time, and the stored event holds ranges rather than owned Strings. A
+/// reply note with e/p tags costs zero allocations beyond the shared
+/// buffers it lands in, and walking a hot timeline window reads
+/// neighboring memory instead of chasing a Vec<Vec<String>> per note.
+///
+/// Tag elements are interned: a thread's worth of replies repeats the
+/// same root id, pubkeys, and relay urls in every event's tags, so
+/// repeated elements share one span instead of being copied per event.
+pub struct EventArena {
+    /// every event string, end to end; String so slicing stays safe
+    bytes: String,
+    /// flattened tag elements, as ranges into `bytes`
+    tag_elems: Vec<Span>,
+    /// per-tag ranges into `tag_elems`
+    tags: Vec<Span>,
+    /// tag elements already in the buffer, keyed by content hash. The
+    /// candidate spans are verified by byte comparison, so a hash
+    /// collision can never alias two different strings.
+    interned: HashMap<u64, Vec<Span>>,
+    events: HashMap<EventId, Stored>,
+}
+
+impl EventArena {
+    pub fn new() -> Self {
+        EventArena {
+            bytes: String::new(),
+            tag_elems: vec![],
+            tags: vec![],
+            interned: HashMap::new(),
+            events: HashMap::new(),
+        }
+    }
+
+    fn push_str(&mut self, s: &str) -> Span {
+        let start = self.bytes.len() as u32;
+        self.bytes.push_str(s);
+        Span {
+            start,
+            end: self.bytes.len() as u32,
+        }
+    }
+
+    /// The span for `s`, reusing an existing copy in the buffer if one
+    /// was interned before, appending and interning it otherwise.
+    fn intern_str(&mut self, s: &str) -> Span {
+        let mut hasher = DefaultHasher::new();
+        s.hash(&mut hasher);
+        let key = hasher.finish();
+
+        if let Some(spans) = self.interned.get(&key) {
+            for span in spans {
+                if &self.bytes[span.start as usize..span.end as usize] == s {
+                    return *span;
+                }
+            }
+        }
+
+        let span = self.push_str(s);
+        self.interned.entry(key).or_default().push(span);
+        span
+    }
+
+    /// Copy an event into the arena. Returns false if it was already
+    /// stored; the arena is append-only and an event's strings never
+    /// change.
+    pub fn insert(&mut self, ev: &Event) -> bool {
+        if self.events.contains_key(&ev.id) {
+            return false;
+        }
+
+        let content = self.push_str(&ev.content);
+
+        let tags_start = self.tags.len() as u32;
+        for tag in &ev.tags {
+            let elems_start = self.tag_elems.len() as u32;
+            for elem in tag {
+                let span = self.intern_str(elem);
+                self.tag_elems.push(span);
+            }
+            self.tags.push(Span {
+                start: elems_start,
+                end: self.tag_elems.len() as u32,
+            });
+        }
+
+        self.events.insert(
+            ev.id,
+            Stored {
+                pubkey: ev.pubkey,
+                created_at: ev.created_at,
+                kind: ev.kind,
+                sig: ev.sig,
+                content,
+                tags: Span {
+                    start: tags_start,
+                    end: self.tags.len() as u32,
+                },
+            },
+        );
+        true
+    }
+
+    pub fn contains(&self, id: &EventId) -> bool {
+        self.events.contains_key(id)
+    }
+
+    pub fn get(&self, id: &EventId) -> Option<EventRef<'_>> {
+        self.events.get(id).map(|ev| EventRef {
+            arena: self,
+            id: *id,
+            ev,
+        })
+    }
+
+    pub fn len(&self) -> usize {
+        self.events.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.events.is_empty()
+    }
+
+    pub fn iter(&self) -> impl Iterator<Item = EventRef<'_>> {
+        self.events.iter().map(move |(id, ev)| EventRef {
+            arena: self,
+            id: *id,
+            ev,
+        })
+    }
+}
+
+/// A borrowed view of one stored event. Strings come straight out of the
+/// arena buffer; nothing is copied.
+#[derive(Clone, Copy)]
+pub struct EventRef<'a> {
+    arena: &'a EventArena,
+    id: EventId,
+    ev: &'a Stored,
+}
+
+impl<'a> EventRef<'a> {
+    pub fn id(&self) -> EventId {
+        self.id
+    }
+
+    pub fn pubkey(&self) -> &'a Pubkey {
+        &self.ev.pubkey
+    }
+
+    pub fn created_at(&self) -> u64 {
+        self.ev.created_at
+    }
+
+    pub fn kind(&self) -> u64 {
+        self.ev.kind
+    }
+
+    pub fn content(&self) -> &'a str {
+        let span = self.ev.content;
+        &self.arena.bytes[span.start as usize..span.end as usize]
+    }
+
+    pub fn n_tags(&self) -> usize {
+        (self.ev.tags.end - self.ev.tags.start) as usize
+    }
+
+    /// The elements of tag `ix` as arena slices.
+    pub fn tag(&self, ix: usize) -> impl Iterator<Item = &'a str> {
+        let arena = self.arena;
+        let tag = arena.tags[self.ev.tags.start as usize + ix];
+        arena.tag_elems[tag.start as usize..tag.end as usize]
+            .iter()
+            .map(move |span| &arena.bytes[span.start as usize..span.end as usize])
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn test_event(n: u8, content: &str, tags: Vec<Vec<String>>) -> Event {
+        Event {
+            id: EventId::new([n; 32]),
+            pubkey: Pubkey::new([2; 32]),
+            created_at: 100 + n as u64,
+            kind: 1,
+            tags,
+            content: content.to_string(),
+            sig: Sig::new([0; 64]),
+        }
+    }
+
+    #[test]
+    fn test_roundtrip() {
+        let mut arena = EventArena::new();
+        let ev = test_event(
+            1,
+            "hello world",
+            vec![
+                vec!["e".to_string(), "abcd".to_string(), "root".to_string()],
+                vec!["p".to_string(), "ef01".to_string()],
+            ],
+        );
+
+        assert!(arena.insert(&ev));
+        assert!(!arena.insert(&ev));
+        assert_eq!(arena.len(), 1);
+
+        let got = arena.get(&ev.id).expect("stored");
+        assert_eq!(got.content(), "hello world");
+        assert_eq!(got.created_at(), ev.created_at);
+        assert_eq!(got.kind(), 1);
+        assert_eq!(got.n_tags(), 2);
+        let tag0: Vec<&str> = got.tag(0).collect();
+        assert_eq!(tag0, vec!["e", "abcd", "root"]);
+        let tag1: Vec<&str> = got.tag(1).collect();
+        assert_eq!(tag1, vec!["p", "ef01"]);
+    }
+
+    #[test]
+    fn test_strings_are_contiguous() {
+        let mut arena = EventArena::new();
+        arena.insert(&test_event(1, "first", vec![vec!["t".to_string()]]));
+        arena.insert(&test_event(2, "second", vec![]));
+
+        // one buffer, laid out in insertion order
+        assert_eq!(arena.bytes, "firsttsecond");
+    }
+
+    #[test]
+    fn test_repeated_tag_elems_interned() {
+        let mut arena = EventArena::new();
+        let tags = vec![vec!["e".to_string(), "abcd".to_string()]];
+        arena.insert(&test_event(1, "one", tags.clone()));
+        arena.insert(&test_event(2, "two", tags));
+
+        // the shared root id is stored once and both events read it back
+        assert_eq!(arena.bytes.matches("abcd").count(), 1);
+        let tag: Vec<&str> = arena.get(&EventId::new([2; 32])).unwrap().tag(0).collect();
+        assert_eq!(tag, vec!["e", "abcd"]);
+    }
+}
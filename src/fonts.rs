@@ -29,9 +29,41 @@ pub fn setup_fonts(ctx: &egui::Context) {
     ctx.set_fonts(fonts);
 }
 
+/// Just the latin UI faces. Building the first font atlas from these two
+/// instead of the full set is a visible chunk of time-to-first-frame on
+/// slow devices, so this is all the Initializing frame installs; the
+/// fallbacks in [`full_fonts`] are swapped in moments later.
+fn base_fonts() -> FontDefinitions {
+    let mut font_data: BTreeMap<String, FontData> = BTreeMap::new();
+    let mut families = BTreeMap::new();
+
+    font_data.insert(
+        "DejaVuSans".to_owned(),
+        FontData::from_static(include_bytes!("../assets/fonts/DejaVuSansSansEmoji.ttf")),
+    );
+    font_data.insert(
+        "DejaVuSansBold".to_owned(),
+        FontData::from_static(include_bytes!(
+            "../assets/fonts/DejaVuSans-Bold-SansEmoji.ttf"
+        )),
+    );
+
+    families.insert(FontFamily::Proportional, vec!["DejaVuSans".to_owned()]);
+    families.insert(FontFamily::Monospace, vec!["DejaVuSans".to_owned()]);
+    families.insert(
+        FontFamily::Name("Bold".into()),
+        vec!["DejaVuSansBold".to_owned()],
+    );
+
+    FontDefinitions {
+        font_data,
+        families,
+    }
+}
+
 // Use gossip's approach to font loading. This includes japanese fonts
 // for rending stuff from japanese users.
-pub fn setup_gossip_fonts(ctx: &egui::Context) {
+fn full_fonts() -> FontDefinitions {
     let mut font_data: BTreeMap<String, FontData> = BTreeMap::new();
     let mut families = BTreeMap::new();
 
@@ -95,10 +127,34 @@ pub fn setup_gossip_fonts(ctx: &egui::Context) {
         vec!["DejaVuSansBold".to_owned()],
     );
 
-    let defs = FontDefinitions {
+    FontDefinitions {
         font_data,
         families,
-    };
+    }
+}
 
-    ctx.set_fonts(defs);
+/// Install the base faces now and hot-swap the full set (emoji, mono,
+/// CJK when enabled) in from a background thread. `set_fonts` only
+/// queues the definitions; egui rebuilds its atlas on the frame after
+/// the swap lands, so the expensive rebuild happens behind the first
+/// paint instead of in front of it.
+#[cfg(not(target_arch = "wasm32"))]
+pub fn setup_gossip_fonts(ctx: &egui::Context) {
+    ctx.set_fonts(base_fonts());
+
+    let ctx = ctx.clone();
+    std::thread::Builder::new()
+        .name("fonts".to_string())
+        .spawn(move || {
+            ctx.set_fonts(full_fonts());
+            ctx.request_repaint();
+        })
+        .expect("spawn font thread");
+}
+
+/// No threads on wasm, and the browser already painted a splash while
+/// the module loaded; install everything up front.
+#[cfg(target_arch = "wasm32")]
+pub fn setup_gossip_fonts(ctx: &egui::Context) {
+    ctx.set_fonts(full_fonts());
 }
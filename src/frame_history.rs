@@ -1,7 +1,51 @@
 use egui::util::History;
 
+/// How many spike frames we keep breakdowns for.
+const WORST_FRAMES: usize = 8;
+
+/// Where one frame's UI-thread time went. Image decode and signature
+/// verification already run on worker threads, so what shows up here is
+/// the slice each subsystem takes out of the frame itself; whatever
+/// isn't accounted for (egui layout, tessellation, the rest of the app)
+/// lands in `rest`.
+#[derive(Clone, Copy, Default)]
+pub struct FrameBreakdown {
+    /// when the frame ended, in egui time
+    pub at: f64,
+    /// seconds spent applying ingested events
+    pub ingest: f32,
+    /// seconds spent laying out and painting timeline notes
+    pub render_notes: f32,
+    /// whole-frame cpu seconds
+    pub total: f32,
+}
+
+impl FrameBreakdown {
+    pub fn rest(&self) -> f32 {
+        (self.total - self.ingest - self.render_notes).max(0.0)
+    }
+
+    /// The subsystem that owned the biggest slice of this frame.
+    pub fn owner(&self) -> &'static str {
+        let rest = self.rest();
+        if self.ingest >= self.render_notes && self.ingest >= rest {
+            "ingest"
+        } else if self.render_notes >= rest {
+            "notes"
+        } else {
+            "rest"
+        }
+    }
+}
+
 pub struct FrameHistory {
     frame_times: History<f32>,
+    /// breakdown being accumulated for the frame in progress
+    current: FrameBreakdown,
+    /// the worst frames seen since startup (or the last clear), so a
+    /// hiccup report can be matched to the subsystem that caused it
+    worst: Vec<FrameBreakdown>,
+    pub show_overlay: bool,
 }
 
 impl Default for FrameHistory {
@@ -10,6 +54,9 @@ impl Default for FrameHistory {
         let max_len = (max_age * 300.0).round() as usize;
         Self {
             frame_times: History::new(0..max_len, max_age),
+            current: FrameBreakdown::default(),
+            worst: vec![],
+            show_overlay: false,
         }
     }
 }
@@ -22,6 +69,77 @@ impl FrameHistory {
             *latest = previous_frame_time; // rewrite history now that we know
         }
         self.frame_times.add(now, previous_frame_time); // projected
+
+        // close out the breakdown the previous frame accumulated, now
+        // that eframe has told us what the whole frame cost
+        let mut done = std::mem::take(&mut self.current);
+        done.at = now;
+        done.total = previous_frame_time;
+        self.retain_if_worst(done);
+    }
+
+    /// Add to this frame's ingest slice.
+    pub fn record_ingest(&mut self, secs: f32) {
+        self.current.ingest += secs;
+    }
+
+    /// Add to this frame's note layout/paint slice.
+    pub fn record_render_notes(&mut self, secs: f32) {
+        self.current.render_notes += secs;
+    }
+
+    fn retain_if_worst(&mut self, frame: FrameBreakdown) {
+        if self.worst.len() < WORST_FRAMES {
+            self.worst.push(frame);
+            return;
+        }
+        let mut min_ix = 0;
+        for (ix, kept) in self.worst.iter().enumerate() {
+            if kept.total < self.worst[min_ix].total {
+                min_ix = ix;
+            }
+        }
+        if frame.total > self.worst[min_ix].total {
+            self.worst[min_ix] = frame;
+        }
+    }
+
+    /// The jank overlay body: the worst frames since the last clear,
+    /// each with its per-subsystem breakdown and the subsystem that
+    /// owned the spike.
+    pub fn jank_ui(&mut self, ui: &mut egui::Ui) {
+        ui.label(format!(
+            "mean {:.2} ms / frame, worst frames since last clear:",
+            1e3 * self.mean_frame_time()
+        ));
+
+        let now = ui.input(|i| i.time);
+        let mut frames = self.worst.clone();
+        frames.sort_by(|a, b| b.total.total_cmp(&a.total));
+
+        egui::Grid::new("jank_frames").striped(true).show(ui, |ui| {
+            ui.monospace("age");
+            ui.monospace("total");
+            ui.monospace("ingest");
+            ui.monospace("notes");
+            ui.monospace("rest");
+            ui.monospace("owner");
+            ui.end_row();
+
+            for frame in &frames {
+                ui.monospace(format!("{:.0}s", now - frame.at));
+                ui.monospace(format!("{:.2}ms", 1e3 * frame.total));
+                ui.monospace(format!("{:.2}ms", 1e3 * frame.ingest));
+                ui.monospace(format!("{:.2}ms", 1e3 * frame.render_notes));
+                ui.monospace(format!("{:.2}ms", 1e3 * frame.rest()));
+                ui.monospace(frame.owner());
+                ui.end_row();
+            }
+        });
+
+        if ui.button("clear").clicked() {
+            self.worst.clear();
+        }
     }
 
     pub fn mean_frame_time(&self) -> f32 {
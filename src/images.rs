@@ -1,53 +1,106 @@
+use crate::atlas::AtlasHandle;
 use crate::error::Error;
 use crate::result::Result;
-use egui::{Color32, ColorImage, TextureHandle};
+use egui::{Color32, ColorImage};
 use egui_extras::image::FitTo;
 use image::imageops::FilterType;
 use poll_promise::Promise;
 
+#[cfg(not(target_arch = "wasm32"))]
+use std::collections::hash_map::DefaultHasher;
+#[cfg(not(target_arch = "wasm32"))]
+use std::hash::{Hash, Hasher};
+#[cfg(not(target_arch = "wasm32"))]
+use std::io::{Read, Write};
+#[cfg(not(target_arch = "wasm32"))]
+use std::path::PathBuf;
+#[cfg(not(target_arch = "wasm32"))]
+use tracing::{debug, warn};
+
+/// The per-pixel mask check for the antialias band at the circle's edge.
+/// Same math as the old full-image loop, but only ever run on the few
+/// pixels per row that sit near the edge.
+fn mask_edge_pixel(pixel: &mut Color32, x_offset: f32, y_offset: f32, edge_radius: f32) {
+    // The radius to this pixel (may be inside or outside the circle)
+    let pixel_radius_squared: f32 = x_offset * x_offset + y_offset * y_offset;
+
+    // If inside of the avatar circle
+    if pixel_radius_squared <= edge_radius * edge_radius {
+        // squareroot to find how many pixels we are from the edge
+        let pixel_radius: f32 = pixel_radius_squared.sqrt();
+        let distance = edge_radius - pixel_radius;
+
+        // If we are within 1 pixel of the edge, we should fade, to
+        // antialias the edge of the circle. 1 pixel from the edge should
+        // be 100% of the original color, and right on the edge should be
+        // 0% of the original color.
+        if distance <= 1.0 {
+            *pixel = Color32::from_rgba_premultiplied(
+                (pixel.r() as f32 * distance) as u8,
+                (pixel.g() as f32 * distance) as u8,
+                (pixel.b() as f32 * distance) as u8,
+                (pixel.a() as f32 * distance) as u8,
+            );
+        }
+    } else {
+        // Outside of the avatar circle
+        *pixel = Color32::TRANSPARENT;
+    }
+}
+
 pub fn round_image(image: &mut ColorImage) {
     #[cfg(feature = "profiling")]
     puffin::profile_function!();
 
+    let width = image.size[0];
+    let height = image.size[1];
+
     // The radius to the edge of of the avatar circle
-    let edge_radius = image.size[0] as f32 / 2.0;
-    let edge_radius_squared = edge_radius * edge_radius;
-
-    for (pixnum, pixel) in image.pixels.iter_mut().enumerate() {
-        // y coordinate
-        let uy = pixnum / image.size[0];
-        let y = uy as f32;
-        let y_offset = edge_radius - y;
-
-        // x coordinate
-        let ux = pixnum % image.size[0];
-        let x = ux as f32;
-        let x_offset = edge_radius - x;
-
-        // The radius to this pixel (may be inside or outside the circle)
-        let pixel_radius_squared: f32 = x_offset * x_offset + y_offset * y_offset;
-
-        // If inside of the avatar circle
-        if pixel_radius_squared <= edge_radius_squared {
-            // squareroot to find how many pixels we are from the edge
-            let pixel_radius: f32 = pixel_radius_squared.sqrt();
-            let distance = edge_radius - pixel_radius;
-
-            // If we are within 1 pixel of the edge, we should fade, to
-            // antialias the edge of the circle. 1 pixel from the edge should
-            // be 100% of the original color, and right on the edge should be
-            // 0% of the original color.
-            if distance <= 1.0 {
-                *pixel = Color32::from_rgba_premultiplied(
-                    (pixel.r() as f32 * distance) as u8,
-                    (pixel.g() as f32 * distance) as u8,
-                    (pixel.b() as f32 * distance) as u8,
-                    (pixel.a() as f32 * distance) as u8,
-                );
-            }
+    let edge_radius = width as f32 / 2.0;
+
+    // Work row by row: each row intersects the circle in a single span,
+    // so the outside is two slice fills, the interior is untouched, and
+    // only the antialias band at each end needs per-pixel math. No
+    // per-pixel div/mod to recover coordinates, and the fills vectorize.
+    for uy in 0..height {
+        let row = &mut image.pixels[uy * width..(uy + 1) * width];
+        let y_offset = edge_radius - uy as f32;
+
+        let span_squared = edge_radius * edge_radius - y_offset * y_offset;
+        if span_squared <= 0.0 {
+            // row is entirely outside the circle
+            row.fill(Color32::TRANSPARENT);
+            continue;
+        }
+
+        // columns possibly inside the circle
+        let span = span_squared.sqrt();
+        let first = ((edge_radius - span).floor().max(0.0)) as usize;
+        let last = (((edge_radius + span).ceil()) as usize).min(width);
+
+        row[..first].fill(Color32::TRANSPARENT);
+        row[last..].fill(Color32::TRANSPARENT);
+
+        // columns strictly inside the antialias band, which we can skip
+        let inner_squared = (edge_radius - 1.0).max(0.0).powi(2) - y_offset * y_offset;
+        let (inner_first, inner_last) = if inner_squared > 0.0 {
+            let inner_span = inner_squared.sqrt();
+            (
+                (((edge_radius - inner_span).ceil()) as usize).clamp(first, last),
+                (((edge_radius + inner_span).floor()) as usize).clamp(first, last),
+            )
         } else {
-            // Outside of the avatar circle
-            *pixel = Color32::TRANSPARENT;
+            // the whole visible span is edge band
+            (last, last)
+        };
+
+        for ux in first..inner_first {
+            let x_offset = edge_radius - ux as f32;
+            mask_edge_pixel(&mut row[ux], x_offset, y_offset, edge_radius);
+        }
+        for ux in inner_last..last {
+            let x_offset = edge_radius - ux as f32;
+            mask_edge_pixel(&mut row[ux], x_offset, y_offset, edge_radius);
         }
     }
 }
@@ -79,12 +132,16 @@ fn process_pfp_bitmap(size: u32, image: &mut image::DynamicImage) -> ColorImage
     color_image
 }
 
+/// Avatars decode and display at this size; it's also what we ask a
+/// resize proxy for.
+const AVATAR_SIZE: u32 = 100;
+
 fn parse_img_response(response: ehttp::Response) -> Result<ColorImage> {
     #[cfg(feature = "profiling")]
     puffin::profile_function!();
 
     let content_type = response.content_type().unwrap_or_default();
-    let size: u32 = 100;
+    let size: u32 = AVATAR_SIZE;
 
     if content_type.starts_with("image/svg") {
         #[cfg(feature = "profiling")]
@@ -104,24 +161,340 @@ fn parse_img_response(response: ehttp::Response) -> Result<ColorImage> {
     }
 }
 
-pub fn fetch_img(ctx: &egui::Context, url: &str) -> Promise<Result<TextureHandle>> {
-    // TODO: fetch image from local cache
-    fetch_img_from_net(ctx, url)
+/// Cap on the decoded-bitmap cache before we start evicting the least
+/// recently used entries.
+#[cfg(not(target_arch = "wasm32"))]
+const IMG_CACHE_MAX_BYTES: u64 = 64 * 1024 * 1024;
+
+#[cfg(not(target_arch = "wasm32"))]
+fn img_cache_dir() -> Option<PathBuf> {
+    crate::storage::data_dir().map(|d| d.join("img_cache"))
 }
 
-fn fetch_img_from_net(ctx: &egui::Context, url: &str) -> Promise<Result<TextureHandle>> {
-    let (sender, promise) = Promise::new();
-    let request = ehttp::Request::get(url);
-    let ctx = ctx.clone();
-    let cloned_url = url.to_owned();
-    ehttp::fetch(request, move |response| {
-        let handle = response
-            .map_err(Error::Generic)
-            .and_then(parse_img_response)
-            .map(|img| ctx.load_texture(&cloned_url, img, Default::default()));
+#[cfg(not(target_arch = "wasm32"))]
+fn img_cache_path(url: &str) -> Option<PathBuf> {
+    let mut hasher = DefaultHasher::new();
+    url.hash(&mut hasher);
+    img_cache_dir().map(|d| d.join(format!("{:016x}.img", hasher.finish())))
+}
+
+/// Read a decoded-and-rounded bitmap back from the disk cache. The
+/// format is the raw egui pixel buffer behind a tiny width/height
+/// header, so loading is a read straight into the ColorImage with no
+/// image decoding at all.
+#[cfg(not(target_arch = "wasm32"))]
+fn read_cached_img(path: &PathBuf) -> Option<ColorImage> {
+    let mut file = std::fs::File::open(path).ok()?;
+
+    let mut header = [0u8; 8];
+    file.read_exact(&mut header).ok()?;
+    let width = u32::from_le_bytes(header[0..4].try_into().unwrap()) as usize;
+    let height = u32::from_le_bytes(header[4..8].try_into().unwrap()) as usize;
+    if width == 0 || height == 0 || width > 4096 || height > 4096 {
+        return None;
+    }
+
+    let mut rgba = vec![0u8; width * height * 4];
+    file.read_exact(&mut rgba).ok()?;
+
+    // bump mtime so lru eviction sees this entry as fresh
+    let _ = std::fs::File::options()
+        .write(true)
+        .open(path)
+        .and_then(|f| f.set_modified(std::time::SystemTime::now()));
+
+    let pixels: Vec<Color32> = rgba
+        .chunks_exact(4)
+        .map(|px| Color32::from_rgba_premultiplied(px[0], px[1], px[2], px[3]))
+        .collect();
+
+    Some(ColorImage {
+        size: [width, height],
+        pixels,
+    })
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+fn write_cached_img(url: &str, img: &ColorImage) {
+    let path = match img_cache_path(url) {
+        Some(path) => path,
+        None => return,
+    };
+
+    if let Some(parent) = path.parent() {
+        if std::fs::create_dir_all(parent).is_err() {
+            return;
+        }
+    }
+
+    let mut buf = Vec::with_capacity(8 + img.pixels.len() * 4);
+    buf.extend_from_slice(&(img.size[0] as u32).to_le_bytes());
+    buf.extend_from_slice(&(img.size[1] as u32).to_le_bytes());
+    for px in &img.pixels {
+        buf.extend_from_slice(&px.to_array());
+    }
+
+    if let Err(e) = std::fs::File::create(&path).and_then(|mut f| f.write_all(&buf)) {
+        warn!("img cache: write failed: {:?}", e);
+        return;
+    }
+
+    evict_img_cache();
+}
+
+/// Trim the disk cache back under its size cap, oldest mtime first.
+#[cfg(not(target_arch = "wasm32"))]
+fn evict_img_cache() {
+    let dir = match img_cache_dir() {
+        Some(dir) => dir,
+        None => return,
+    };
+
+    let entries = match std::fs::read_dir(&dir) {
+        Ok(entries) => entries,
+        Err(_) => return,
+    };
+
+    let mut files: Vec<(std::time::SystemTime, u64, PathBuf)> = vec![];
+    let mut total: u64 = 0;
+    for entry in entries.flatten() {
+        if let Ok(meta) = entry.metadata() {
+            let mtime = meta.modified().unwrap_or(std::time::UNIX_EPOCH);
+            total += meta.len();
+            files.push((mtime, meta.len(), entry.path()));
+        }
+    }
+
+    if total <= IMG_CACHE_MAX_BYTES {
+        return;
+    }
+
+    files.sort_by_key(|(mtime, _, _)| *mtime);
+    for (_, len, path) in files {
+        if total <= IMG_CACHE_MAX_BYTES {
+            break;
+        }
+        if std::fs::remove_file(&path).is_ok() {
+            debug!("img cache: evicted {:?}", &path);
+            total = total.saturating_sub(len);
+        }
+    }
+}
+
+/// A small fixed pool for image work (disk cache reads, decode, crop,
+/// resize, rounding), so a burst of avatar fetches can't fan out into
+/// hundreds of concurrent decodes.
+#[cfg(not(target_arch = "wasm32"))]
+mod workers {
+    use std::sync::mpsc::{self, Sender};
+    use std::sync::{Arc, Mutex, OnceLock};
+    use std::thread;
+
+    type Job = Box<dyn FnOnce() + Send>;
+
+    static POOL: OnceLock<Mutex<Sender<Job>>> = OnceLock::new();
+
+    fn n_workers() -> usize {
+        thread::available_parallelism()
+            .map(|n| n.get().min(4))
+            .unwrap_or(2)
+    }
+
+    pub fn spawn(job: impl FnOnce() + Send + 'static) {
+        let pool = POOL.get_or_init(|| {
+            let (tx, rx) = mpsc::channel::<Job>();
+            let rx = Arc::new(Mutex::new(rx));
+            for i in 0..n_workers() {
+                let rx = rx.clone();
+                thread::Builder::new()
+                    .name(format!("img-worker-{}", i))
+                    .spawn(move || loop {
+                        let job = rx.lock().unwrap().recv();
+                        match job {
+                            Ok(job) => job(),
+                            Err(_) => return,
+                        }
+                    })
+                    .expect("spawn img worker");
+            }
+            Mutex::new(tx)
+        });
+
+        let _ = pool.lock().unwrap().send(Box::new(job));
+    }
+}
+
+pub fn fetch_img(ctx: &egui::Context, url: &str) -> Promise<Result<AtlasHandle>> {
+    #[cfg(not(target_arch = "wasm32"))]
+    {
+        let (sender, promise) = Promise::new();
+        let ctx = ctx.clone();
+        let url = url.to_owned();
+        workers::spawn(move || {
+            let cached = img_cache_path(&url).and_then(|path| read_cached_img(&path));
+            match cached {
+                Some(img) => {
+                    crate::metrics::IMG_DISK_HITS.incr();
+                    let tex = crate::atlas::insert(&ctx, &url, img);
+                    sender.send(Ok(tex));
+                    ctx.request_repaint();
+                }
+                None => {
+                    crate::metrics::IMG_NET_FETCHES.incr();
+                    fetch_img_from_net(ctx, url, sender);
+                }
+            }
+        });
+        promise
+    }
+
+    #[cfg(target_arch = "wasm32")]
+    {
+        let (sender, promise) = Promise::new();
+        crate::metrics::IMG_NET_FETCHES.incr();
+        fetch_img_from_net(ctx.clone(), url.to_owned(), sender);
+        promise
+    }
+}
+
+/// The resize-proxy url template, read once from DAMUS_IMG_PROXY. The
+/// template must contain "{url}" (replaced with the percent-encoded
+/// origin url) and may contain "{size}" (the avatar pixel size), e.g.
+/// "https://imgproxy.example.com/{size}/plain/{url}".
+fn img_proxy_template() -> Option<&'static str> {
+    use std::sync::OnceLock;
+    static TEMPLATE: OnceLock<Option<String>> = OnceLock::new();
+    TEMPLATE
+        .get_or_init(|| std::env::var("DAMUS_IMG_PROXY").ok())
+        .as_deref()
+}
+
+/// Percent-encode every byte outside the rfc3986 unreserved set, which
+/// is what a url embedded in another url's path needs.
+fn percent_encode(s: &str) -> String {
+    use std::fmt::Write;
+
+    let mut out = String::with_capacity(s.len() * 3);
+    for b in s.bytes() {
+        match b {
+            b'A'..=b'Z' | b'a'..=b'z' | b'0'..=b'9' | b'-' | b'_' | b'.' | b'~' => {
+                out.push(b as char)
+            }
+            _ => {
+                let _ = write!(out, "%{:02X}", b);
+            }
+        }
+    }
+    out
+}
 
-        sender.send(handle); // send the results back to the UI thread.
-        ctx.request_repaint();
+fn apply_proxy_template(template: &str, url: &str, size: u32) -> String {
+    template
+        .replace("{size}", &size.to_string())
+        .replace("{url}", &percent_encode(url))
+}
+
+/// Fetch an avatar, preferring a configured resize proxy so the wire
+/// carries ~100px images instead of whatever multi-megabyte original
+/// the user posted. A failed proxy fetch falls back to the origin url,
+/// so a down proxy only costs latency, never avatars. ehttp delivers
+/// whole response bodies, so there is no partial-body early abort here;
+/// the proxy path is where the bandwidth win lives.
+fn fetch_img_from_net(
+    ctx: egui::Context,
+    url: String,
+    sender: poll_promise::Sender<Result<AtlasHandle>>,
+) {
+    let proxied = match img_proxy_template() {
+        Some(template) => apply_proxy_template(template, &url, AVATAR_SIZE),
+        None => return fetch_img_direct(ctx, url, sender),
+    };
+
+    let request = ehttp::Request::get(&proxied);
+    ehttp::fetch(request, move |response| match response {
+        Ok(ref r) if r.ok => {
+            crate::metrics::IMG_PROXY_BYTES.add(r.bytes.len() as u64);
+            dispatch_img_response(ctx, url, sender, response);
+        }
+        _ => {
+            // proxy down or it rejected this url; pay for the original
+            crate::metrics::IMG_PROXY_FALLBACKS.incr();
+            fetch_img_direct(ctx, url, sender);
+        }
     });
-    promise
+}
+
+fn fetch_img_direct(
+    ctx: egui::Context,
+    url: String,
+    sender: poll_promise::Sender<Result<AtlasHandle>>,
+) {
+    let request = ehttp::Request::get(&url);
+    ehttp::fetch(request, move |response| {
+        if let Ok(ref r) = response {
+            crate::metrics::IMG_DIRECT_BYTES.add(r.bytes.len() as u64);
+        }
+        dispatch_img_response(ctx, url, sender, response);
+    });
+}
+
+fn dispatch_img_response(
+    ctx: egui::Context,
+    url: String,
+    sender: poll_promise::Sender<Result<AtlasHandle>>,
+    response: core::result::Result<ehttp::Response, String>,
+) {
+    // decode/crop/resize/round on the worker pool, not on the ehttp
+    // callback thread
+    #[cfg(not(target_arch = "wasm32"))]
+    workers::spawn(move || handle_img_response(ctx, url, sender, response));
+
+    #[cfg(target_arch = "wasm32")]
+    handle_img_response(ctx, url, sender, response);
+}
+
+fn handle_img_response(
+    ctx: egui::Context,
+    url: String,
+    sender: poll_promise::Sender<Result<AtlasHandle>>,
+    response: core::result::Result<ehttp::Response, String>,
+) {
+    let img = response.map_err(Error::Generic).and_then(parse_img_response);
+
+    #[cfg(not(target_arch = "wasm32"))]
+    if let Ok(ref img) = img {
+        write_cached_img(&url, img);
+    }
+
+    let handle = img.map(|img| crate::atlas::insert(&ctx, &url, img));
+
+    sender.send(handle); // send the results back to the UI thread.
+    ctx.request_repaint();
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_percent_encode() {
+        assert_eq!(
+            percent_encode("https://a.example/pic.png?x=1 2"),
+            "https%3A%2F%2Fa.example%2Fpic.png%3Fx%3D1%202"
+        );
+        assert_eq!(percent_encode("Az09-_.~"), "Az09-_.~");
+    }
+
+    #[test]
+    fn test_apply_proxy_template() {
+        let out = apply_proxy_template(
+            "https://proxy.example/{size}/plain/{url}",
+            "https://a.example/p.png",
+            100,
+        );
+        assert_eq!(
+            out,
+            "https://proxy.example/100/plain/https%3A%2F%2Fa.example%2Fp.png"
+        );
+    }
 }
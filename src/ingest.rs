@@ -0,0 +1,348 @@
+use enostr::{ClientMessage, Note, RelayEvent, RelayMessage, RelayPool};
+
+#[cfg(not(target_arch = "wasm32"))]
+use std::sync::mpsc;
+#[cfg(not(target_arch = "wasm32"))]
+use std::sync::Arc;
+#[cfg(not(target_arch = "wasm32"))]
+use std::thread;
+#[cfg(not(target_arch = "wasm32"))]
+use std::time::Duration;
+
+use tracing::{debug, error};
+
+/// A pre-digested relay event, ready for the UI thread to apply.
+pub struct IngestItem {
+    pub relay: String,
+    pub event: RelayEvent,
+    /// Precomputed render structure for kind-1 events, shattered on the
+    /// verifier workers so render never walks tags or scans content.
+    pub note: Option<Note>,
+}
+
+/// How many items we pack into one batch before handing it over.
+const MAX_BATCH: usize = 512;
+
+/// On wasm the pool is drained on the browser main thread, so one
+/// batch's parse+verify work has to fit inside a frame. Much smaller
+/// than the native batch; the budget loop in the app works off the rest
+/// across following frames.
+#[cfg(target_arch = "wasm32")]
+const WASM_MAX_BATCH: usize = 32;
+
+/// How many undelivered batches we allow to queue before the ingest
+/// thread blocks. Keeps a disconnected UI from buffering unbounded.
+#[cfg(not(target_arch = "wasm32"))]
+const BATCH_QUEUE_DEPTH: usize = 128;
+
+enum Command {
+    AddUrl(String),
+    Send(ClientMessage),
+    SendTo(ClientMessage, String),
+    SendFastest(ClientMessage),
+}
+
+/// Owns the relay sockets and runs message parsing and dedup off the UI
+/// thread. The UI gets batches of already-parsed, already-deduplicated
+/// items over a bounded channel and is only woken up when a batch is
+/// ready. On wasm there are no threads, so the same interface drives the
+/// pool inline.
+#[cfg(not(target_arch = "wasm32"))]
+pub struct Ingest {
+    cmd_tx: mpsc::Sender<Command>,
+    batch_rx: mpsc::Receiver<Vec<IngestItem>>,
+    thread: thread::JoinHandle<()>,
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+impl Ingest {
+    pub fn new(wakeup: impl Fn() + Send + Sync + 'static) -> Self {
+        let (cmd_tx, cmd_rx) = mpsc::channel();
+        let (batch_tx, batch_rx) = mpsc::sync_channel(BATCH_QUEUE_DEPTH);
+
+        let thread = thread::Builder::new()
+            .name("ingest".to_string())
+            .spawn(move || ingest_thread(cmd_rx, batch_tx, Arc::new(wakeup)))
+            .expect("spawn ingest thread");
+
+        Ingest {
+            cmd_tx,
+            batch_rx,
+            thread,
+        }
+    }
+
+    fn command(&mut self, cmd: Command) {
+        if self.cmd_tx.send(cmd).is_err() {
+            error!("ingest thread is gone");
+            return;
+        }
+        self.thread.thread().unpark();
+    }
+
+    pub fn add_url(&mut self, url: String) {
+        self.command(Command::AddUrl(url));
+    }
+
+    pub fn send(&mut self, msg: ClientMessage) {
+        self.command(Command::Send(msg));
+    }
+
+    pub fn send_to(&mut self, msg: ClientMessage, relay_url: String) {
+        self.command(Command::SendTo(msg, relay_url));
+    }
+
+    /// Route a one-shot query to whichever relay the pool currently
+    /// rates fastest, instead of broadcasting or hard-picking a url.
+    pub fn send_fastest(&mut self, msg: ClientMessage) {
+        self.command(Command::SendFastest(msg));
+    }
+
+    /// A batch of pre-digested relay events, if one is ready. Never
+    /// blocks.
+    pub fn try_recv_batch(&mut self) -> Option<Vec<IngestItem>> {
+        self.batch_rx.try_recv().ok()
+    }
+}
+
+#[cfg(not(target_arch = "wasm32"))]
+fn ingest_thread(
+    cmd_rx: mpsc::Receiver<Command>,
+    batch_tx: mpsc::SyncSender<Vec<IngestItem>>,
+    wakeup: Arc<dyn Fn() + Send + Sync>,
+) {
+    let mut pool = RelayPool::new();
+    let verifier = verifier::VerifierPool::new();
+
+    // Relay socket activity should wake this thread, not the UI; the UI
+    // only needs to wake when a digested batch is ready for it.
+    let handle = thread::current();
+    let relay_wakeup = move || handle.unpark();
+
+    loop {
+        loop {
+            match cmd_rx.try_recv() {
+                Ok(Command::AddUrl(url)) => {
+                    if let Err(e) = pool.add_url(url, relay_wakeup.clone()) {
+                        error!("{:?}", e);
+                    }
+                }
+                Ok(Command::Send(msg)) => pool.send(&msg),
+                Ok(Command::SendTo(msg, url)) => pool.send_to(&msg, &url),
+                Ok(Command::SendFastest(msg)) => pool.send_to_fastest(&msg),
+                Err(mpsc::TryRecvError::Empty) => break,
+                Err(mpsc::TryRecvError::Disconnected) => return,
+            }
+        }
+
+        pool.keepalive_ping(relay_wakeup.clone());
+
+        loop {
+            let batch = digest_batch(&mut pool, MAX_BATCH);
+            if batch.is_empty() {
+                break;
+            }
+            let batch = verifier.verify_batch(batch);
+            if batch.is_empty() {
+                continue;
+            }
+            if batch_tx.send(batch).is_err() {
+                return;
+            }
+            wakeup();
+        }
+
+        // woken early by socket activity or a command; the timeout just
+        // keeps the keepalive ping loop ticking
+        thread::park_timeout(Duration::from_millis(500));
+    }
+}
+
+/// Drain up to `max` pre-digested items from the pool. Cross-relay
+/// dedup happens inside the pool now, before frames are even parsed.
+fn digest_batch(pool: &mut RelayPool, max: usize) -> Vec<IngestItem> {
+    let mut batch = vec![];
+
+    while let Some(ev) = pool.try_recv() {
+        let relay = ev.relay.to_owned();
+        let event = ev.event;
+
+        batch.push(IngestItem {
+            relay,
+            event,
+            note: None,
+        });
+        if batch.len() >= max {
+            break;
+        }
+    }
+
+    batch
+}
+
+/// Drop items whose event fails id or signature verification, and
+/// shatter the survivors' content into render blocks while we're
+/// already touching every byte of the event. Everything downstream of
+/// this is verified, so no per-event flag is needed: the timeline and
+/// the event log only ever see good events.
+fn verify_and_shatter(items: Vec<IngestItem>) -> Vec<IngestItem> {
+    items
+        .into_iter()
+        .filter_map(|mut item| {
+            if let RelayEvent::Message(RelayMessage::Event(_, ev)) = &item.event {
+                if let Err(err) = ev.verify() {
+                    debug!("dropping event {:?} from {}: {:?}", ev.id, item.relay, err);
+                    return None;
+                }
+                if ev.kind == 1 {
+                    item.note = Some(Note::from_event(ev));
+                }
+            }
+            Some(item)
+        })
+        .collect()
+}
+
+/// Schnorr verification is the most expensive thing the ingest path does,
+/// so batches are scattered across a small worker pool and gathered back
+/// in order. A full backfill batch verifies on all cores while the ingest
+/// thread keeps draining sockets and the UI keeps painting.
+#[cfg(not(target_arch = "wasm32"))]
+mod verifier {
+    use super::IngestItem;
+    use std::sync::{mpsc, Arc, Mutex};
+    use std::thread;
+
+    /// Batches smaller than this verify inline; the channel round trip
+    /// costs more than the crypto.
+    const MIN_SCATTER: usize = 32;
+
+    /// Items per scattered job.
+    const CHUNK: usize = 64;
+
+    type Job = (
+        usize,
+        Vec<IngestItem>,
+        mpsc::Sender<(usize, Vec<IngestItem>)>,
+    );
+
+    pub struct VerifierPool {
+        job_tx: mpsc::Sender<Job>,
+    }
+
+    impl VerifierPool {
+        pub fn new() -> Self {
+            let (job_tx, job_rx) = mpsc::channel::<Job>();
+            let job_rx = Arc::new(Mutex::new(job_rx));
+
+            let n_workers = thread::available_parallelism()
+                .map(|n| n.get())
+                .unwrap_or(1)
+                .min(4);
+
+            for n in 0..n_workers {
+                let job_rx = job_rx.clone();
+                thread::Builder::new()
+                    .name(format!("verify-{}", n))
+                    .spawn(move || loop {
+                        let job = job_rx.lock().unwrap().recv();
+                        let (ix, items, result_tx) = match job {
+                            Ok(job) => job,
+                            Err(_) => return,
+                        };
+                        // receiver gone just means the batch was abandoned
+                        let _ = result_tx.send((ix, super::verify_and_shatter(items)));
+                    })
+                    .expect("spawn verifier thread");
+            }
+
+            VerifierPool { job_tx }
+        }
+
+        /// Verify a digested batch, dropping items that fail. Item order
+        /// is preserved so EOSE never overtakes the events it closes.
+        pub fn verify_batch(&self, batch: Vec<IngestItem>) -> Vec<IngestItem> {
+            if batch.len() < MIN_SCATTER {
+                return super::verify_and_shatter(batch);
+            }
+
+            let (result_tx, result_rx) = mpsc::channel();
+            let mut n_jobs = 0;
+            let mut items = batch.into_iter();
+            loop {
+                let chunk: Vec<IngestItem> = items.by_ref().take(CHUNK).collect();
+                if chunk.is_empty() {
+                    break;
+                }
+                if self.job_tx.send((n_jobs, chunk, result_tx.clone())).is_err() {
+                    // workers are gone; treat the batch as unverifiable
+                    return vec![];
+                }
+                n_jobs += 1;
+            }
+            drop(result_tx);
+
+            let mut results: Vec<(usize, Vec<IngestItem>)> = result_rx.iter().collect();
+            results.sort_by_key(|(ix, _)| *ix);
+            results.into_iter().flat_map(|(_, items)| items).collect()
+        }
+    }
+}
+
+/// On wasm everything runs on the browser main thread, so Ingest is a
+/// thin wrapper that drives the pool inline with the same batching and
+/// dedup behavior as the native ingest thread, bounded by
+/// WASM_MAX_BATCH per call so parse+verify fits inside a frame.
+///
+/// Moving this behind a real Web Worker is the eventual goal; nothing
+/// outside this struct touches the pool, so a worker port only has to
+/// reimplement these five methods over postMessage. The blocker is that
+/// the build has no worker entry point or bindgen glue yet, and
+/// ewebsock's wasm sockets are bound to the thread that opened them.
+#[cfg(target_arch = "wasm32")]
+pub struct Ingest {
+    pool: RelayPool,
+    wakeup: std::sync::Arc<dyn Fn() + Send + Sync>,
+}
+
+#[cfg(target_arch = "wasm32")]
+impl Ingest {
+    pub fn new(wakeup: impl Fn() + Send + Sync + 'static) -> Self {
+        Ingest {
+            pool: RelayPool::new(),
+            wakeup: std::sync::Arc::new(wakeup),
+        }
+    }
+
+    pub fn add_url(&mut self, url: String) {
+        let wakeup = self.wakeup.clone();
+        if let Err(e) = self.pool.add_url(url, move || wakeup()) {
+            error!("{:?}", e);
+        }
+    }
+
+    pub fn send(&mut self, msg: ClientMessage) {
+        self.pool.send(&msg);
+    }
+
+    pub fn send_to(&mut self, msg: ClientMessage, relay_url: String) {
+        self.pool.send_to(&msg, &relay_url);
+    }
+
+    pub fn send_fastest(&mut self, msg: ClientMessage) {
+        self.pool.send_to_fastest(&msg);
+    }
+
+    pub fn try_recv_batch(&mut self) -> Option<Vec<IngestItem>> {
+        let wakeup = self.wakeup.clone();
+        self.pool.keepalive_ping(move || wakeup());
+
+        // no threads here; verify inline, batches stay frame-sized
+        let batch = verify_and_shatter(digest_batch(&mut self.pool, WASM_MAX_BATCH));
+        if batch.is_empty() {
+            None
+        } else {
+            Some(batch)
+        }
+    }
+}
@@ -2,12 +2,18 @@ mod app;
 //mod camera;
 mod contacts;
 mod error;
+pub mod events;
 //mod note;
 //mod block;
 mod abbrev;
+pub mod atlas;
 mod fonts;
-mod images;
+pub mod images;
+mod ingest;
+pub mod metrics;
 mod result;
+mod storage;
+pub mod timeline;
 mod ui;
 mod frame_history;
 
@@ -0,0 +1,120 @@
+//! App-side always-on metrics: image cache traffic and ingest queue
+//! pressure, plus a periodic machine-readable dump next to the event
+//! log. The counter types live in enostr so the relay path can use the
+//! same ones.
+
+use enostr::metrics::{Counter, Histogram};
+use std::sync::atomic::{AtomicU64, Ordering};
+
+/// Avatar bitmaps served straight from the disk cache.
+pub static IMG_DISK_HITS: Counter = Counter::new();
+
+/// Avatar fetches that had to go to the network.
+pub static IMG_NET_FETCHES: Counter = Counter::new();
+
+/// Image bytes fetched through the resize proxy.
+pub static IMG_PROXY_BYTES: Counter = Counter::new();
+
+/// Image bytes fetched directly from the origin url. Compare against
+/// proxy bytes to see what the proxy is saving on the wire.
+pub static IMG_DIRECT_BYTES: Counter = Counter::new();
+
+/// Proxy fetches that failed and fell back to the origin url.
+pub static IMG_PROXY_FALLBACKS: Counter = Counter::new();
+
+/// Items applied from ingest batches.
+pub static INGEST_ITEMS: Counter = Counter::new();
+
+/// Time spent applying one ingest item on the UI thread.
+pub static INGEST_ITEM_NS: Histogram = Histogram::new();
+
+/// Current carry-over queue depth, set once per frame.
+pub static INGEST_QUEUE_DEPTH: AtomicU64 = AtomicU64::new(0);
+
+pub fn set_queue_depth(depth: usize) {
+    INGEST_QUEUE_DEPTH.store(depth as u64, Ordering::Relaxed);
+}
+
+pub fn queue_depth() -> u64 {
+    INGEST_QUEUE_DEPTH.load(Ordering::Relaxed)
+}
+
+/// One-line json snapshot of every counter we keep. Scraped from
+/// metrics.json in the data dir, so keep the keys stable.
+pub fn dump_json() -> String {
+    use std::fmt::Write;
+
+    let relay = enostr::metrics::per_relay_counts();
+    let mut per_relay = String::new();
+    for (i, (url, count)) in relay.iter().enumerate() {
+        if i > 0 {
+            per_relay.push(',');
+        }
+        let _ = write!(per_relay, "{:?}:{}", url, count);
+    }
+
+    format!(
+        concat!(
+            "{{\"relay_messages\":{},\"per_relay\":{{{}}},",
+            "\"dup_frames_dropped\":{},\"parse_errors\":{},",
+            "\"parse_p50_ns\":{},\"parse_p99_ns\":{},",
+            "\"ingest_items\":{},\"ingest_item_p99_ns\":{},",
+            "\"ingest_queue_depth\":{},",
+            "\"img_disk_hits\":{},\"img_net_fetches\":{},",
+            "\"img_proxy_bytes\":{},\"img_direct_bytes\":{},",
+            "\"img_proxy_fallbacks\":{}}}"
+        ),
+        enostr::metrics::RELAY_MESSAGES.get(),
+        per_relay,
+        enostr::metrics::DUP_FRAMES_DROPPED.get(),
+        enostr::metrics::PARSE_ERRORS.get(),
+        enostr::metrics::PARSE_NS.approx_quantile(0.5),
+        enostr::metrics::PARSE_NS.approx_quantile(0.99),
+        INGEST_ITEMS.get(),
+        INGEST_ITEM_NS.approx_quantile(0.99),
+        queue_depth(),
+        IMG_DISK_HITS.get(),
+        IMG_NET_FETCHES.get(),
+        IMG_PROXY_BYTES.get(),
+        IMG_DIRECT_BYTES.get(),
+        IMG_PROXY_FALLBACKS.get(),
+    )
+}
+
+/// How often the metrics dump is rewritten.
+#[cfg(not(target_arch = "wasm32"))]
+const DUMP_EVERY: std::time::Duration = std::time::Duration::from_secs(10);
+
+/// Rewrite metrics.json in the data dir if it's stale. Called once per
+/// frame; the cost is one Instant compare except every DUMP_EVERY.
+#[cfg(not(target_arch = "wasm32"))]
+pub fn maybe_dump() {
+    use std::sync::Mutex;
+    use std::time::Instant;
+
+    static LAST_DUMP: Mutex<Option<Instant>> = Mutex::new(None);
+
+    let mut last = LAST_DUMP.lock().unwrap();
+    if let Some(at) = *last {
+        if at.elapsed() < DUMP_EVERY {
+            return;
+        }
+    }
+    *last = Some(Instant::now());
+    drop(last);
+
+    if let Some(dir) = crate::storage::data_dir() {
+        let _ = std::fs::write(dir.join("metrics.json"), dump_json());
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_dump_is_json() {
+        let dump = dump_json();
+        serde_json::from_str::<serde_json::Value>(&dump).expect("dump parses as json");
+    }
+}
@@ -0,0 +1,104 @@
+use crate::result::Result;
+use enostr::Event;
+use std::fs::{File, OpenOptions};
+use std::io::{BufRead, BufReader, BufWriter, Write};
+use std::path::PathBuf;
+use tracing::{debug, warn};
+
+/// Where we keep persistent state. Can be overridden with
+/// NOTEDECK_DATA_DIR, otherwise follows XDG conventions.
+pub fn data_dir() -> Option<PathBuf> {
+    if let Ok(dir) = std::env::var("NOTEDECK_DATA_DIR") {
+        return Some(PathBuf::from(dir));
+    }
+
+    if let Ok(dir) = std::env::var("XDG_DATA_HOME") {
+        return Some(PathBuf::from(dir).join("notedeck"));
+    }
+
+    std::env::var("HOME")
+        .ok()
+        .map(|home| PathBuf::from(home).join(".local/share/notedeck"))
+}
+
+/// An append-only, on-disk event log. Events are written as one json
+/// object per line, so the log is robust against a torn tail: a
+/// partially-written last line is simply skipped on the next load. The
+/// store keeps no index of its own; the caller replays the log through
+/// its normal ingest path at startup and dedups against its in-memory
+/// event map before appending.
+pub struct EventStore {
+    writer: BufWriter<File>,
+}
+
+impl EventStore {
+    fn log_path() -> Option<PathBuf> {
+        data_dir().map(|d| d.join("events.jsonl"))
+    }
+
+    /// Open the event log, returning the store handle along with all
+    /// events recovered from previous sessions, oldest first. The caller
+    /// replays these through its normal ingest path.
+    pub fn open() -> Result<(EventStore, Vec<Event>)> {
+        let path = Self::log_path().ok_or_else(|| "no data directory".to_string())?;
+
+        if let Some(parent) = path.parent() {
+            std::fs::create_dir_all(parent)?;
+        }
+
+        let mut events: Vec<Event> = vec![];
+
+        match File::open(&path) {
+            Ok(file) => {
+                let mut skipped = 0;
+                for line in BufReader::new(file).lines() {
+                    let line = line?;
+                    if line.is_empty() {
+                        continue;
+                    }
+                    match Event::from_json(&line) {
+                        Ok(ev) => events.push(ev),
+                        Err(_) => skipped += 1,
+                    }
+                }
+                if skipped > 0 {
+                    warn!("event store: skipped {} corrupt entries", skipped);
+                }
+                debug!("event store: loaded {} events from {:?}", events.len(), &path);
+            }
+            Err(_) => {
+                // first run, no log yet
+            }
+        }
+
+        let file = OpenOptions::new().create(true).append(true).open(&path)?;
+
+        Ok((
+            EventStore {
+                writer: BufWriter::new(file),
+            },
+            events,
+        ))
+    }
+
+    /// Append an event to the log. The caller is expected to have already
+    /// deduplicated, so every append is a new event.
+    pub fn append(&mut self, ev: &Event) {
+        let json = match serde_json::to_string(ev) {
+            Ok(json) => json,
+            Err(e) => {
+                warn!("event store: failed to serialize event: {:?}", e);
+                return;
+            }
+        };
+
+        if let Err(e) = self
+            .writer
+            .write_all(json.as_bytes())
+            .and_then(|_| self.writer.write_all(b"\n"))
+            .and_then(|_| self.writer.flush())
+        {
+            warn!("event store: append failed: {:?}", e);
+        }
+    }
+}
@@ -0,0 +1,150 @@
+use enostr::note::Block;
+use enostr::{EventId, Note, Pubkey};
+use std::collections::{BTreeSet, HashSet};
+
+/// A timeline entry: creation time plus event id, with the id breaking
+/// ties between notes created in the same second.
+#[derive(Debug, Clone, Copy, Eq, PartialEq, Ord, PartialOrd, Hash)]
+pub struct NoteRef {
+    pub created_at: u64,
+    pub id: EventId,
+}
+
+/// What one timeline shows. Empty fields mean no constraint. Every
+/// ingested event is evaluated against each panel's filter exactly once,
+/// so matching must stay cheap: set lookups plus a walk over the note's
+/// pre-shattered hashtag blocks.
+#[derive(Debug, Clone, Default)]
+pub struct TimelineFilter {
+    pub kinds: HashSet<u64>,
+    pub authors: HashSet<Pubkey>,
+    /// lowercase, without the leading '#'
+    pub hashtag: Option<String>,
+}
+
+impl TimelineFilter {
+    /// Fields are passed individually so both owned events and
+    /// arena-backed views can be matched without materializing anything.
+    pub fn matches(&self, kind: u64, pubkey: &Pubkey, content: &str, note: Option<&Note>) -> bool {
+        if !self.kinds.is_empty() && !self.kinds.contains(&kind) {
+            return false;
+        }
+        if !self.authors.is_empty() && !self.authors.contains(pubkey) {
+            return false;
+        }
+        if let Some(hashtag) = &self.hashtag {
+            let note = match note {
+                Some(note) => note,
+                None => return false,
+            };
+            return note.blocks.iter().any(|block| match block {
+                // skip the '#' the range includes
+                Block::Hashtag(r) => content[r.start + 1..r.end].eq_ignore_ascii_case(hashtag),
+                _ => false,
+            });
+        }
+        true
+    }
+}
+
+/// A created_at-ordered timeline index. Keeping it in a b-tree keyed on
+/// (created_at, id) makes inserts O(log n), so out-of-order events
+/// arriving during backfill land in the right position instead of being
+/// prepended, and new events stop memmoving the entire id list.
+pub struct Timeline {
+    index: BTreeSet<NoteRef>,
+}
+
+impl Timeline {
+    pub fn new() -> Self {
+        Timeline {
+            index: BTreeSet::new(),
+        }
+    }
+
+    /// Insert a note into the timeline. Returns false if it was already
+    /// there.
+    pub fn insert(&mut self, created_at: u64, id: EventId) -> bool {
+        self.index.insert(NoteRef { created_at, id })
+    }
+
+    pub fn len(&self) -> usize {
+        self.index.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.index.is_empty()
+    }
+
+    /// Notes in display order, newest first.
+    pub fn notes(&self) -> impl Iterator<Item = &NoteRef> {
+        self.index.iter().rev()
+    }
+
+    /// The oldest note we have, if any. Useful for paging further back.
+    pub fn oldest(&self) -> Option<&NoteRef> {
+        self.index.iter().next()
+    }
+
+    /// The newest note we have, if any.
+    pub fn newest(&self) -> Option<&NoteRef> {
+        self.index.iter().next_back()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn id(n: u8) -> EventId {
+        EventId::new([n; 32])
+    }
+
+    #[test]
+    fn test_out_of_order_inserts_sort() {
+        let mut timeline = Timeline::new();
+        timeline.insert(10, id(1));
+        timeline.insert(30, id(2));
+        timeline.insert(20, id(3));
+
+        let order: Vec<u64> = timeline.notes().map(|n| n.created_at).collect();
+        assert_eq!(order, vec![30, 20, 10]);
+        assert_eq!(timeline.oldest().unwrap().created_at, 10);
+        assert_eq!(timeline.newest().unwrap().created_at, 30);
+    }
+
+    #[test]
+    fn test_duplicate_insert() {
+        let mut timeline = Timeline::new();
+        assert!(timeline.insert(10, id(1)));
+        assert!(!timeline.insert(10, id(1)));
+        assert_eq!(timeline.len(), 1);
+    }
+
+    #[test]
+    fn test_hashtag_filter() {
+        let ev = enostr::Event {
+            id: id(1),
+            pubkey: Pubkey::new([2; 32]),
+            created_at: 10,
+            kind: 1,
+            tags: vec![],
+            content: "gm #Nostr".to_string(),
+            sig: enostr::Sig::new([0; 64]),
+        };
+        let note = Note::from_event(&ev);
+
+        let mut filter = TimelineFilter::default();
+        assert!(filter.matches(ev.kind, &ev.pubkey, &ev.content, Some(&note)));
+
+        filter.hashtag = Some("nostr".to_string());
+        assert!(filter.matches(ev.kind, &ev.pubkey, &ev.content, Some(&note)));
+
+        filter.hashtag = Some("bitcoin".to_string());
+        assert!(!filter.matches(ev.kind, &ev.pubkey, &ev.content, Some(&note)));
+
+        filter.hashtag = None;
+        filter.authors.insert(Pubkey::new([3; 32]));
+        assert!(!filter.matches(ev.kind, &ev.pubkey, &ev.content, Some(&note)));
+    }
+}